@@ -0,0 +1,504 @@
+// latency-bench.cpp
+// Writer -> reader visibility latency and contention benchmark.
+//
+// Writer threads append fixed-size records through one WriteLibrary, each
+// stamped with its commit time (CLOCK_MONOTONIC, comparable across processes
+// on one machine). Writer processes are forked with a WriteLibrary each; the
+// control block has a single writer, so each one appends to its own data and
+// lock file (<data>.<n>, <lock>.<n>). Reader threads and reader processes
+// follow every file with their own ZeroCopyRead and record, for every record,
+// how long after its stamp they saw it. Reported: visibility latency
+// percentiles, writer throughput, and the time readers spent stalled on the
+// writers' locks.
+//
+//   ./latency_bench --writers 2 --writer-processes 2 --reader-threads 2 --reader-processes 2 --records 20000 --wait poll
+
+#include "write-library.h"
+#include "zero-copy-read-library.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/wait.h>
+#include <thread>
+#include <time.h>
+#include <vector>
+
+static constexpr size_t RECORD_SIZE = 64;
+static constexpr std::uint64_t RECORD_MAGIC = 0x3143455259544c5aULL; // "ZLTYREC1"
+
+// Fixed-size record; readers find record i at offset i * RECORD_SIZE
+struct Record {
+    std::uint64_t magic;
+    std::uint64_t writer;
+    std::uint64_t sequence;
+    std::uint64_t commit_ns;     // Stamped just before writeData
+    char padding[RECORD_SIZE - 4 * sizeof(std::uint64_t) - 1];
+    char newline;
+};
+static_assert(sizeof(Record) == RECORD_SIZE, "Record must be RECORD_SIZE bytes");
+
+struct LatencyConfig {
+    int writers = 1;
+    int writer_processes = 0;
+    int reader_threads = 1;
+    int reader_processes = 0;
+    size_t records = 10000;        // Per writer
+    long interval_us = 10;         // Pause between records of one writer
+    std::string wait = "poll";     // poll: spin on refresh(); wait: waitForBytes()
+    std::string data_path = "latency-data.txt";
+    std::string lock_path = "latency-lock.lock";
+    int timeout_s = 60;
+};
+
+// One data file and its writer's lock file; records are appended after a
+// filler prefix of base bytes
+struct Stream {
+    std::string data_path;
+    std::string lock_path;
+    size_t base = 0;
+    size_t records = 0;
+};
+
+// What one reader measured
+struct ReaderResult {
+    std::vector<std::uint64_t> latency_ns;
+    std::uint64_t lock_checks = 0;
+    std::uint64_t lock_wait_ns = 0;
+    std::uint64_t bad_records = 0;
+};
+
+static std::uint64_t nowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+// Fresh data and lock files. WriteLibrary takes the size of the file at open
+// time as its capacity (famfs preallocation) and grows it through famfs, so
+// the data file starts with a filler prefix as large as the run; readers
+// follow the records appended after it.
+static bool createStream(const Stream& stream) {
+    int data_fd = open(stream.data_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    int lock_fd = open(stream.lock_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (data_fd < 0 || lock_fd < 0 || write(lock_fd, "", 1) != 1) {
+        perror("create files");
+        return false;
+    }
+    std::string filler(RECORD_SIZE * 1024, ' ');
+    for (size_t i = RECORD_SIZE - 1; i < filler.size(); i += RECORD_SIZE) {
+        filler[i] = '\n';
+    }
+    for (size_t written = 0; written < stream.base;) {
+        size_t chunk = std::min(filler.size(), stream.base - written);
+        if (write(data_fd, filler.data(), chunk) != static_cast<ssize_t>(chunk)) {
+            perror("write filler");
+            return false;
+        }
+        written += chunk;
+    }
+    close(data_fd);
+    close(lock_fd);
+    return true;
+}
+
+// Appends config.records records, each stamped just before it is written
+static void writeRecords(const LatencyConfig& config, WriteLibrary& writer, std::mutex& writer_lock,
+                         int writer_id) {
+    Record record{};
+    record.magic = RECORD_MAGIC;
+    record.writer = writer_id;
+    memset(record.padding, ' ', sizeof(record.padding));
+    record.newline = '\n';
+    for (size_t i = 0; i < config.records; ++i) {
+        record.sequence = i;
+        {
+            std::lock_guard<std::mutex> guard(writer_lock);
+            record.commit_ns = nowNs();
+            writer.writeData(reinterpret_cast<const char*>(&record), sizeof(record));
+        }
+        if (config.interval_us > 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(config.interval_us));
+        }
+    }
+}
+
+static ReaderResult runReader(const LatencyConfig& config, const Stream& stream) {
+    ReaderResult result;
+    result.latency_ns.reserve(stream.records);
+    ZeroCopyReadOptions options;
+    options.follow = true;
+    ZeroCopyRead reader(stream.data_path.c_str(), stream.lock_path.c_str(), options);
+
+    size_t total_bytes = stream.base + stream.records * RECORD_SIZE;
+    size_t offset = stream.base;
+    std::uint64_t deadline = nowNs() + config.timeout_s * 1000000000ULL;
+    while (offset < total_bytes && nowNs() < deadline) {
+        size_t size = config.wait == "wait"
+            ? reader.waitForBytes(offset + RECORD_SIZE, 100)
+            : reader.refresh();
+        size_t available = (std::min(size, total_bytes) - std::min(size, offset)) / RECORD_SIZE * RECORD_SIZE;
+        if (available == 0) {
+            continue;
+        }
+        // One coordination check for everything that arrived
+        std::string_view arrived = reader.view(offset, available);
+        std::uint64_t seen_ns = nowNs();
+        for (size_t i = 0; i + RECORD_SIZE <= arrived.size(); i += RECORD_SIZE) {
+            Record record;
+            memcpy(&record, arrived.data() + i, sizeof(record));
+            if (record.magic != RECORD_MAGIC) {
+                result.bad_records++;
+                continue;
+            }
+            result.latency_ns.push_back(seen_ns - record.commit_ns);
+        }
+        offset += arrived.size();
+    }
+    ReaderStats stats = reader.stats();
+    result.lock_checks = stats.lock_checks;
+    result.lock_wait_ns = stats.lock_wait_ns;
+    return result;
+}
+
+static void addResult(ReaderResult& total, const ReaderResult& result) {
+    total.latency_ns.insert(total.latency_ns.end(), result.latency_ns.begin(), result.latency_ns.end());
+    total.lock_checks += result.lock_checks;
+    total.lock_wait_ns += result.lock_wait_ns;
+    total.bad_records += result.bad_records;
+}
+
+// One reader follows every stream, with a thread per stream so that a
+// blocking wait on one file does not delay what it sees on the others
+static ReaderResult followStreams(const LatencyConfig& config, const std::vector<Stream>& streams) {
+    if (streams.size() == 1) {
+        return runReader(config, streams[0]);
+    }
+    std::vector<ReaderResult> results(streams.size());
+    std::vector<std::thread> followers;
+    for (size_t s = 0; s < streams.size(); ++s) {
+        followers.emplace_back([&config, &streams, &results, s]() {
+            results[s] = runReader(config, streams[s]);
+        });
+    }
+    ReaderResult total;
+    for (size_t s = 0; s < streams.size(); ++s) {
+        followers[s].join();
+        addResult(total, results[s]);
+    }
+    return total;
+}
+
+// Reader processes send their result back through a pipe
+static bool writeAllBytes(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, bytes, size);
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool readAllBytes(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = read(fd, bytes, size);
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+static void sendResult(int fd, const ReaderResult& result) {
+    std::uint64_t header[4] = { result.latency_ns.size(), result.lock_checks, result.lock_wait_ns, result.bad_records };
+    writeAllBytes(fd, header, sizeof(header));
+    writeAllBytes(fd, result.latency_ns.data(), result.latency_ns.size() * sizeof(std::uint64_t));
+}
+
+static bool receiveResult(int fd, ReaderResult& result) {
+    std::uint64_t header[4];
+    if (!readAllBytes(fd, header, sizeof(header))) {
+        return false;
+    }
+    result.latency_ns.resize(header[0]);
+    result.lock_checks = header[1];
+    result.lock_wait_ns = header[2];
+    result.bad_records = header[3];
+    return readAllBytes(fd, result.latency_ns.data(), result.latency_ns.size() * sizeof(std::uint64_t));
+}
+
+static std::uint64_t percentile(const std::vector<std::uint64_t>& sorted, double fraction) {
+    if (sorted.empty()) {
+        return 0;
+    }
+    return sorted[std::min(sorted.size() - 1, static_cast<size_t>(fraction * sorted.size()))];
+}
+
+static void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --writers N            writer threads sharing the WriteLibrary (default 1)\n"
+              << "  --writer-processes N   writer processes, each with its own WriteLibrary and file (default 0)\n"
+              << "  --reader-threads N     reader threads (default 1)\n"
+              << "  --reader-processes N   reader processes (default 0)\n"
+              << "  --records N            records per writer (default 10000)\n"
+              << "  --interval-us N        pause between records of one writer (default 10)\n"
+              << "  --wait poll|wait       readers spin on refresh() or block in waitForBytes()\n"
+              << "  --data FILE --lock FILE\n";
+}
+
+int main(int argc, char** argv) {
+    LatencyConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "--writers") {
+            config.writers = std::stoi(value);
+        } else if (arg == "--writer-processes") {
+            config.writer_processes = std::stoi(value);
+        } else if (arg == "--reader-threads") {
+            config.reader_threads = std::stoi(value);
+        } else if (arg == "--reader-processes") {
+            config.reader_processes = std::stoi(value);
+        } else if (arg == "--records") {
+            config.records = std::stoull(value);
+        } else if (arg == "--interval-us") {
+            config.interval_us = std::stol(value);
+        } else if (arg == "--wait") {
+            config.wait = value;
+        } else if (arg == "--data") {
+            config.data_path = value;
+        } else if (arg == "--lock") {
+            config.lock_path = value;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (config.writers < 0 || config.writer_processes < 0 || config.writers + config.writer_processes < 1
+        || config.reader_threads + config.reader_processes < 1) {
+        std::cerr << "Need at least one writer and one reader\n";
+        return EXIT_FAILURE;
+    }
+
+    // The writer threads share the first stream, each writer process has one
+    std::vector<Stream> streams;
+    if (config.writers > 0) {
+        streams.push_back({ config.data_path, config.lock_path, 0, config.records * config.writers });
+    }
+    for (int p = 0; p < config.writer_processes; ++p) {
+        std::string suffix = "." + std::to_string(p);
+        streams.push_back({ config.data_path + suffix, config.lock_path + suffix, 0, config.records });
+    }
+    size_t total_records = 0;
+    for (Stream& stream : streams) {
+        stream.base = stream.records * RECORD_SIZE;
+        total_records += stream.records;
+        if (!createStream(stream)) {
+            return EXIT_FAILURE;
+        }
+    }
+    auto removeStreams = [&streams]() {
+        for (const Stream& stream : streams) {
+            unlink(stream.data_path.c_str());
+            unlink(stream.lock_path.c_str());
+        }
+    };
+
+    try {
+        // Writer processes are forked first. Each opens its WriteLibrary,
+        // which claims its control block, reports ready, then waits for a
+        // byte on the start pipe; its WriterStats come back on the same pipe
+        // it reported ready on.
+        int start[2];
+        if (pipe(start) != 0) {
+            perror("pipe");
+            return EXIT_FAILURE;
+        }
+        std::vector<pid_t> writer_children;
+        std::vector<int> writer_pipes;
+        for (int p = 0; p < config.writer_processes; ++p) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                perror("pipe");
+                return EXIT_FAILURE;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                close(start[1]);
+                const Stream& stream = streams[streams.size() - config.writer_processes + p];
+                try {
+                    WriteLibrary writer(stream.data_path.c_str(), stream.lock_path.c_str());
+                    char go;
+                    if (!writeAllBytes(fds[1], "r", 1) || !readAllBytes(start[0], &go, 1)) {
+                        _exit(1);
+                    }
+                    std::mutex writer_lock;  // Uncontended: one writer per process
+                    writeRecords(config, writer, writer_lock, config.writers + p);
+                    WriterStats stats = writer.stats();
+                    writeAllBytes(fds[1], &stats, sizeof(stats));
+                } catch (const std::exception& ex) {
+                    std::cerr << "Writer process error: " << ex.what() << "\n";
+                    _exit(1);
+                }
+                close(fds[1]);
+                _exit(0);
+            }
+            close(fds[1]);
+            writer_children.push_back(pid);
+            writer_pipes.push_back(fds[0]);
+        }
+        close(start[0]);
+        bool writers_ready = true;
+        for (int fd : writer_pipes) {
+            char ready;
+            writers_ready = readAllBytes(fd, &ready, 1) && writers_ready;
+        }
+        if (!writers_ready) {
+            std::cerr << "A writer process failed to open its file\n";
+            close(start[1]);
+            for (size_t p = 0; p < writer_children.size(); ++p) {
+                close(writer_pipes[p]);
+                waitpid(writer_children[p], nullptr, 0);
+            }
+            removeStreams();
+            return EXIT_FAILURE;
+        }
+
+        // The writer claims the control block before any reader opens the file
+        std::unique_ptr<WriteLibrary> writer;
+        if (config.writers > 0) {
+            writer.reset(new WriteLibrary(config.data_path.c_str(), config.lock_path.c_str()));
+        }
+
+        // Reader processes are forked before any thread exists
+        std::vector<pid_t> children;
+        std::vector<int> pipes;
+        for (int p = 0; p < config.reader_processes; ++p) {
+            int fds[2];
+            if (pipe(fds) != 0) {
+                perror("pipe");
+                return EXIT_FAILURE;
+            }
+            pid_t pid = fork();
+            if (pid == 0) {
+                close(fds[0]);
+                close(start[1]);
+                sendResult(fds[1], followStreams(config, streams));
+                close(fds[1]);
+                _exit(0);
+            }
+            close(fds[1]);
+            children.push_back(pid);
+            pipes.push_back(fds[0]);
+        }
+
+        std::vector<ReaderResult> results(config.reader_threads);
+        std::vector<std::thread> readers;
+        for (int t = 0; t < config.reader_threads; ++t) {
+            readers.emplace_back([&config, &results, &streams, t]() {
+                results[t] = followStreams(config, streams);
+            });
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));  // Let the readers map the files
+
+        // Writer threads contend for the single writer; writer processes
+        // start on the same signal
+        std::mutex writer_lock;
+        std::uint64_t write_start = nowNs();
+        std::string go(config.writer_processes, 'g');
+        writeAllBytes(start[1], go.data(), go.size());
+        close(start[1]);
+        std::vector<std::thread> writers;
+        for (int w = 0; w < config.writers; ++w) {
+            writers.emplace_back([&config, &writer, &writer_lock, w]() {
+                writeRecords(config, *writer, writer_lock, w);
+            });
+        }
+        for (std::thread& thread : writers) {
+            thread.join();
+        }
+        WriterStats writer_stats = writer ? writer->stats() : WriterStats();
+        size_t failed_writers = 0;
+        for (size_t p = 0; p < writer_children.size(); ++p) {
+            WriterStats stats;
+            int status = 0;
+            bool ok = readAllBytes(writer_pipes[p], &stats, sizeof(stats));
+            close(writer_pipes[p]);
+            waitpid(writer_children[p], &status, 0);
+            if (!ok || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                std::cerr << "Writer process " << writer_children[p] << " failed\n";
+                failed_writers++;
+                continue;
+            }
+            writer_stats.write_calls += stats.write_calls;
+            writer_stats.batch_writes += stats.batch_writes;
+            writer_stats.bytes_written += stats.bytes_written;
+            writer_stats.syncs += stats.syncs;
+            writer_stats.growth_events += stats.growth_events;
+            writer_stats.growth_ns += stats.growth_ns;
+        }
+        double write_seconds = (nowNs() - write_start) / 1e9;
+
+        for (std::thread& thread : readers) {
+            thread.join();
+        }
+        for (size_t p = 0; p < children.size(); ++p) {
+            ReaderResult result;
+            if (!receiveResult(pipes[p], result)) {
+                std::cerr << "Reader process " << children[p] << " sent no result\n";
+            }
+            results.push_back(std::move(result));
+            close(pipes[p]);
+            waitpid(children[p], nullptr, 0);
+        }
+
+        std::vector<std::uint64_t> latencies;
+        std::uint64_t lock_checks = 0;
+        std::uint64_t lock_wait_ns = 0;
+        std::uint64_t bad_records = 0;
+        size_t incomplete = 0;
+        for (const ReaderResult& result : results) {
+            latencies.insert(latencies.end(), result.latency_ns.begin(), result.latency_ns.end());
+            lock_checks += result.lock_checks;
+            lock_wait_ns += result.lock_wait_ns;
+            bad_records += result.bad_records;
+            incomplete += result.latency_ns.size() != total_records;
+        }
+        std::sort(latencies.begin(), latencies.end());
+
+        std::cout << "[latency] " << config.writers << " writer threads, " << config.writer_processes
+                  << " writer processes, " << config.reader_threads
+                  << " reader threads, " << config.reader_processes << " reader processes, "
+                  << total_records << " records of " << RECORD_SIZE << " bytes, wait = " << config.wait << "\n";
+        std::cout << "  writer:     " << total_records / write_seconds << " records/s ("
+                  << formatStats(writer_stats) << ")\n";
+        std::cout << "  visibility: p50 " << percentile(latencies, 0.5) << " ns, p99 "
+                  << percentile(latencies, 0.99) << " ns, p999 " << percentile(latencies, 0.999)
+                  << " ns, max " << (latencies.empty() ? 0 : latencies.back()) << " ns over "
+                  << latencies.size() << " observations\n";
+        std::cout << "  readers:    " << lock_checks << " lock checks, stalled " << lock_wait_ns
+                  << " ns on the writer's lock, " << bad_records << " torn records, "
+                  << incomplete << " readers incomplete\n";
+        removeStreams();
+        return (bad_records == 0 && incomplete == 0 && failed_writers == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        removeStreams();
+        return EXIT_FAILURE;
+    }
+}
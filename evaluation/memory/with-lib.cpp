@@ -3,7 +3,14 @@
 // without making an extra copy.
 
 #include "zero-copy-read-library.h"
+#include "zip-kernels.h"
+#include "parallel-scan.h"
+#include "zero-copy-read-set.h"
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
 #include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include <iostream>
 #include <cstdlib>
@@ -21,6 +28,99 @@ unsigned long long calculate_nsec_difference(struct timespec start, struct times
     return sec_diff * 1000000000LL + nsec_diff;
 }
 
+struct FaultCounts {
+    long minor;
+    long major;
+};
+
+FaultCounts getPageFaults() {
+    struct rusage u{};
+    getrusage(RUSAGE_SELF, &u);
+    return { u.ru_minflt, u.ru_majflt };
+}
+
+// Open the file with the given access options, then time the first byte and
+// a sequential scan, counting the page faults both take
+void measureAccessPattern(const char* label, const char* dataPath, const char* lockPath,
+                          const ZeroCopyReadOptions& options) {
+    FaultCounts before = getPageFaults();
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ZeroCopyRead reader(dataPath, lockPath, options);
+    volatile char first = reader.view(0, 1)[0];
+    (void)first;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    unsigned long long first_byte_ns = calculate_nsec_difference(start, end);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int64_t byte_sum = 0;
+    for (size_t offset = 0; offset < reader.getFileSize(); offset += 4096) {
+        reader.prefetchAhead(offset);
+        std::string_view page = reader.view(offset, std::min<size_t>(4096, reader.getFileSize() - offset));
+        for (char c : page) {
+            byte_sum += static_cast<unsigned char>(c);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    FaultCounts after = getPageFaults();
+
+    std::cout << "[access " << label << "] time to first byte: " << first_byte_ns
+              << " ns, scan: " << calculate_nsec_difference(start, end)
+              << " ns, page faults: " << after.minor - before.minor << " minor, "
+              << after.major - before.major << " major (byte sum " << byte_sum << ")\n";
+}
+
+// dTLB read misses of the calling thread, or -1 if perf events are unavailable
+int openDtlbMissCounter() {
+    struct perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HW_CACHE;
+    attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+// Scan the file with and without huge pages, reporting how much of the
+// mapping huge pages backed and the dTLB misses of the scan
+void measureHugePages(const char* label, const char* dataPath, const char* lockPath, bool hugePages) {
+    ZeroCopyReadOptions options;
+    options.huge_pages = hugePages;
+    options.populate = true;
+    ZeroCopyRead reader(dataPath, lockPath, options);
+
+    int counter = openDtlbMissCounter();
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_RESET, 0);
+        ioctl(counter, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    std::string_view data = reader.view(0, reader.getFileSize());
+    int64_t byte_sum = 0;
+    for (size_t i = 0; i < data.size(); i += 64) {  // One load per cache line
+        byte_sum += static_cast<unsigned char>(data[i]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    long long misses = -1;
+    if (counter >= 0) {
+        ioctl(counter, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(counter, &misses, sizeof(misses)) != sizeof(misses)) {
+            misses = -1;
+        }
+        close(counter);
+    }
+
+    std::cout << "[" << label << "] huge pages: " << reader.getHugePageBytes() / 1024
+              << " KB of " << reader.getFileSize() / 1024 << " KB, scan: "
+              << calculate_nsec_difference(start, end) << " ns, dTLB misses: ";
+    if (misses < 0) {
+        std::cout << "n/a";
+    } else {
+        std::cout << misses;
+    }
+    std::cout << " (byte sum " << byte_sum << ")\n";
+}
+
 long getPeakRSSKB() {
     struct rusage u{};
     getrusage(RUSAGE_SELF, &u);
@@ -61,8 +161,87 @@ int main(int argc, char** argv) {
         std::cout << "[zero-copy] peak RSS = "
                   << getPeakRSSKB() << " KB\n";
         std::cout << "[zero-copy] Total sum: " << total_sum << "\n";
-        std::cout << "[zero-copy] Time taken: "
-                  << calculate_nsec_difference(start, end) << " ns\n";
+        unsigned long long iterator_ns = calculate_nsec_difference(start, end);
+        std::cout << "[zero-copy] Time taken: " << iterator_ns << " ns\n";
+        std::cout << "[zero-copy] reader 1 stats: " << formatStats(reader1.stats()) << "\n";
+
+        // Same loop with both files in one ZeroCopyReadSet: a single
+        // coordination check per step instead of one per file
+        {
+            ZeroCopyReadSet set({ data1Path, data2Path }, lockPath);
+            int set_sum = 0;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            while (!(++set)) {
+                set_sum += set.value<int>(0) + set.value<int>(1);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            std::cout << "[reader-set] Total sum: " << set_sum << "\n";
+            std::cout << "[reader-set] Time taken: "
+                      << calculate_nsec_difference(start, end) << " ns\n";
+            std::cout << "[reader-set] stats: " << formatStats(set.stats()) << "\n";
+        }
+
+        // Same files, packed int32 pairs summed by the SIMD zip kernel
+        // (the computation of without-lib)
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        int64_t kernel_sum = zipReduce<int32_t>(reader1, reader2, ZipOp::Sum);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+
+        unsigned long long kernel_ns = calculate_nsec_difference(start, end);
+        std::cout << "[zip-kernel] peak RSS = "
+                  << getPeakRSSKB() << " KB\n";
+        std::cout << "[zip-kernel] Total sum: " << kernel_sum << "\n";
+        std::cout << "[zip-kernel] Time taken: " << kernel_ns << " ns\n";
+
+        // The same int32 pair sum through the generic zipReduce, one
+        // element at a time, as the baseline for the kernel
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        uint64_t generic_sum = zipReduce<int32_t>(uint64_t(0),
+            [](int32_t x, int32_t y) { return static_cast<uint64_t>(x) + static_cast<uint64_t>(y); },
+            [](uint64_t acc, uint64_t value) { return acc + value; },
+            reader1, reader2);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        unsigned long long generic_ns = calculate_nsec_difference(start, end);
+        std::cout << "[zip-generic] Total sum: " << static_cast<int64_t>(generic_sum) << "\n";
+        std::cout << "[zip-generic] Time taken: " << generic_ns << " ns\n";
+        std::cout << "[zip-kernel] Speedup over zip-generic (same int32 pair sum): "
+                  << static_cast<double>(generic_ns) / (kernel_ns ? kernel_ns : 1) << "x\n";
+
+        // Thread-count sweep: byte sum of the first file with parallelScan
+        for (size_t threads = 1; threads <= 8; threads *= 2) {
+            ParallelScanOptions options;
+            options.threads = threads;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            int64_t scan_sum = parallelScan<int64_t>(reader1,
+                [](int64_t& sum, std::string_view chunk, size_t) {
+                    for (char c : chunk) {
+                        sum += static_cast<unsigned char>(c);
+                    }
+                },
+                [](int64_t& total, const int64_t& sum) { total += sum; },
+                options);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            std::cout << "[parallel-scan] " << threads << " threads: byte sum " << scan_sum
+                      << ", time taken: " << calculate_nsec_difference(start, end) << " ns\n";
+        }
+
+
+        // Page faults and time-to-first-byte of a sequential scan per
+        // access-pattern option
+        ZeroCopyReadOptions access;
+        measureAccessPattern("default", data1Path, lockPath, access);
+        access.access = AccessPattern::Sequential;
+        measureAccessPattern("sequential", data1Path, lockPath, access);
+        access.prefetch_distance = 1 << 20;
+        measureAccessPattern("sequential+prefetch", data1Path, lockPath, access);
+        access.prefetch_distance = 0;
+        access.populate = true;
+        measureAccessPattern("populate", data1Path, lockPath, access);
+
+        // Huge-page mode; on tmpfs it needs shmem_enabled set to advise or
+        // always in /sys/kernel/mm/transparent_hugepage
+        measureHugePages("small pages", data1Path, lockPath, false);
+        measureHugePages("huge pages", data1Path, lockPath, true);
 
     } catch (const std::exception& ex) {
         std::cerr << "Error: " << ex.what() << "\n";
@@ -0,0 +1,597 @@
+// read-path-bench.cpp
+// Read-path benchmark: sweeps dataset size, access pattern and API, comparing
+// the library (iterator, readData, view, record iterator) against raw mmap,
+// read, pread and std::ifstream. Datasets are generated on first use and
+// reused afterwards. Results are written as JSON or CSV, one row per
+// (dataset, size, API, pattern). Each configuration runs in a forked child so
+// its peak RSS is its own.
+//
+//   ./read_path_bench --sizes 16M,1G,16G --repeats 5 --format csv --output results.csv
+
+#include "zero-copy-read-library.h"
+#include "record-iterator.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <vector>
+
+struct BenchConfig {
+    std::vector<size_t> sizes = { 16ULL << 20, 256ULL << 20 };
+    std::vector<std::string> apis = { "iterator", "iterator-seqlock", "iterator-immutable", "readData", "view",
+                                      "records", "mmap", "read", "pread", "ifstream" };
+    std::vector<std::string> patterns = { "sequential", "random" };
+    std::vector<std::string> backends = { "auto" };  // Read backends of the library APIs
+    std::string dir = ".";
+    std::string lock_path = "lockfile.lock";
+    std::string format = "json";
+    std::string output;
+    size_t block_size = 4096;
+    size_t iterator_limit = 8ULL << 20;  // The byte iterator is slow: cap what it reads
+    int warmup = 1;
+    int repeats = 3;
+};
+
+struct BenchResult {
+    std::string dataset;
+    size_t file_size;
+    std::string api;
+    std::string backend;    // "-" for the raw APIs
+    std::string pattern;
+    size_t bytes_per_run;
+    double best_mib_s;
+    double mean_mib_s;
+    unsigned long long p50_ns;
+    unsigned long long p99_ns;
+    unsigned long long p999_ns;
+    long rss_kb;            // Largest RSS sampled while the data was mapped or buffered
+    long peak_rss_kb;       // ru_maxrss of the child that ran the configuration
+    std::uint64_t checksum;
+};
+
+// The numbers a configuration's child sends back to the parent
+struct BenchNumbers {
+    size_t bytes_per_run;
+    double best_mib_s;
+    double mean_mib_s;
+    unsigned long long p50_ns;
+    unsigned long long p99_ns;
+    unsigned long long p999_ns;
+    long rss_kb;
+    std::uint64_t checksum;
+};
+
+// One timed sample per block; checksum keeps the reads from being optimized away
+struct RunOutput {
+    std::vector<unsigned long long> block_ns;
+    size_t bytes;
+    std::uint64_t checksum;
+    long rss_kb;  // Sampled before the reader, mapping or stream is released
+};
+
+static unsigned long long nowNs() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+static std::uint64_t checksumBytes(const char* data, size_t size) {
+    std::uint64_t sum = 0;
+    size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        sum += word;
+    }
+    for (; i < size; ++i) {
+        sum += static_cast<unsigned char>(data[i]);
+    }
+    return sum;
+}
+
+static long currentRSSKB() {
+    long pages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm != nullptr) {
+        long total;
+        if (fscanf(statm, "%ld %ld", &total, &pages) != 2) {
+            pages = 0;
+        }
+        fclose(statm);
+    }
+    return pages * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static bool writeAllBytes(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, bytes, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+static bool readAllBytes(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = read(fd, bytes, size);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= n;
+    }
+    return true;
+}
+
+static size_t parseSize(const std::string& text) {
+    size_t value = std::stoull(text);
+    switch (text.empty() ? ' ' : text.back()) {
+        case 'K': case 'k': return value << 10;
+        case 'M': case 'm': return value << 20;
+        case 'G': case 'g': return value << 30;
+        default: return value;
+    }
+}
+
+static std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+// Write (or reuse) a dataset of exactly `size` bytes: random 64-bit words for
+// "binary", comma-separated numeric records for "text"
+static std::string ensureDataset(const BenchConfig& config, const std::string& kind, size_t size) {
+    std::string path = config.dir + "/read-path-" + kind + "-" + std::to_string(size) + ".dat";
+    struct stat existing;
+    if (stat(path.c_str(), &existing) == 0 && static_cast<size_t>(existing.st_size) == size) {
+        return path;
+    }
+    int out = open(path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0644);
+    if (out < 0) {
+        perror("open dataset");
+        throw std::runtime_error("Failed to create dataset " + path);
+    }
+    std::mt19937_64 random(size);
+    std::string chunk;
+    size_t written = 0;
+    while (written < size) {
+        chunk.clear();
+        size_t target = std::min<size_t>(1 << 20, size - written);
+        if (kind == "binary") {
+            while (chunk.size() + sizeof(std::uint64_t) <= target) {
+                std::uint64_t word = random();
+                chunk.append(reinterpret_cast<const char*>(&word), sizeof(word));
+            }
+            chunk.append(target - chunk.size(), '\0');
+        } else {
+            while (chunk.size() < target) {
+                chunk += std::to_string(random() % 1000000) + "," + std::to_string(random() % 1000) + ",record\n";
+            }
+            chunk.resize(target);
+            chunk.back() = '\n';
+        }
+        if (write(out, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) {
+            perror("write dataset");
+            close(out);
+            throw std::runtime_error("Failed to write dataset " + path);
+        }
+        written += chunk.size();
+    }
+    close(out);
+    return path;
+}
+
+// Offsets of the blocks read by one run, in access order
+static std::vector<size_t> blockOffsets(size_t file_size, size_t block_size, const std::string& pattern) {
+    std::vector<size_t> offsets;
+    for (size_t offset = 0; offset < file_size; offset += block_size) {
+        offsets.push_back(offset);
+    }
+    if (pattern == "random") {
+        std::mt19937_64 random(file_size ^ block_size);
+        std::shuffle(offsets.begin(), offsets.end(), random);
+    }
+    return offsets;
+}
+
+static ZeroCopyReadOptions readerOptions(const std::string& backend) {
+    ZeroCopyReadOptions options;
+    if (backend == "mmap") {
+        options.backend = ReadBackend::Mmap;
+    } else if (backend == "io_uring") {
+        options.backend = ReadBackend::IoUring;
+    } else if (backend != "auto") {
+        throw std::runtime_error("Unknown backend " + backend);
+    }
+    return options;
+}
+
+static bool libraryApi(const std::string& api) {
+    return api == "iterator" || api == "iterator-seqlock" || api == "iterator-immutable"
+        || api == "readData" || api == "view" || api == "records";
+}
+
+// Byte at a time through any reader instantiation; one sample per block of bytes
+template <typename Reader>
+static void iterate(Reader& reader, size_t limit, size_t block_size, RunOutput& result) {
+    for (size_t done = 0; done < limit;) {
+        unsigned long long start = nowNs();
+        size_t block_end = std::min(limit, done + block_size);
+        for (; done < block_end; ++done) {
+            result.checksum += static_cast<unsigned char>(*reader);
+            ++reader;
+        }
+        result.block_ns.push_back(nowNs() - start);
+    }
+    result.bytes = limit;
+}
+
+static RunOutput runOnce(const BenchConfig& config, const std::string& path, const std::string& api,
+                         const std::string& backend, const std::vector<size_t>& offsets, size_t file_size) {
+    RunOutput result{ {}, 0, 0, 0 };
+    result.block_ns.reserve(offsets.size());
+    size_t block_size = config.block_size;
+    std::vector<char> buffer(block_size);
+    auto blockLength = [&](size_t offset) { return std::min(block_size, file_size - offset); };
+
+    if (api == "iterator") {
+        ZeroCopyRead reader(path.c_str(), config.lock_path.c_str(), readerOptions(backend));
+        iterate(reader, std::min(file_size, config.iterator_limit), block_size, result);
+        result.rss_kb = currentRSSKB();
+    } else if (api == "iterator-seqlock") {
+        SeqlockZeroCopyRead reader(path.c_str(), config.lock_path.c_str(), readerOptions(backend));
+        iterate(reader, std::min(file_size, config.iterator_limit), block_size, result);
+        result.rss_kb = currentRSSKB();
+    } else if (api == "iterator-immutable") {
+        ImmutableZeroCopyRead reader(path.c_str(), config.lock_path.c_str(), readerOptions(backend));
+        iterate(reader, std::min(file_size, config.iterator_limit), block_size, result);
+        result.rss_kb = currentRSSKB();
+    } else if (api == "readData" || api == "view") {
+        ZeroCopyRead reader(path.c_str(), config.lock_path.c_str(), readerOptions(backend));
+        for (size_t offset : offsets) {
+            size_t length = blockLength(offset);
+            unsigned long long start = nowNs();
+            if (api == "readData") {
+                reader.readData(offset, length, buffer.data());
+                result.checksum += checksumBytes(buffer.data(), length);
+            } else {
+                std::string_view block = reader.view(offset, length);
+                result.checksum += checksumBytes(block.data(), block.size());
+            }
+            result.block_ns.push_back(nowNs() - start);
+            result.bytes += length;
+        }
+        result.rss_kb = currentRSSKB();
+    } else if (api == "records") {
+        // Sequential only: one sample per block's worth of records
+        ZeroCopyRead reader(path.c_str(), config.lock_path.c_str(), readerOptions(backend));
+        size_t since_sample = 0;
+        unsigned long long start = nowNs();
+        for (std::string_view record : records(reader)) {
+            result.checksum += record.size();
+            since_sample += record.size() + 1;
+            if (since_sample >= block_size) {
+                result.block_ns.push_back(nowNs() - start);
+                since_sample = 0;
+                start = nowNs();
+            }
+        }
+        result.bytes = file_size;
+        result.rss_kb = currentRSSKB();
+    } else if (api == "mmap") {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            perror("open");
+            throw std::runtime_error("Failed to open " + path);
+        }
+        void* map = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            perror("mmap");
+            close(fd);
+            throw std::runtime_error("mmap failed");
+        }
+        const char* base = static_cast<const char*>(map);
+        for (size_t offset : offsets) {
+            size_t length = blockLength(offset);
+            unsigned long long start = nowNs();
+            result.checksum += checksumBytes(base + offset, length);
+            result.block_ns.push_back(nowNs() - start);
+            result.bytes += length;
+        }
+        result.rss_kb = currentRSSKB();
+        munmap(map, file_size);
+        close(fd);
+    } else if (api == "read" || api == "pread") {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            perror("open");
+            throw std::runtime_error("Failed to open " + path);
+        }
+        size_t position = 0;
+        for (size_t offset : offsets) {
+            size_t length = blockLength(offset);
+            unsigned long long start = nowNs();
+            ssize_t n;
+            if (api == "pread") {
+                n = pread(fd, buffer.data(), length, offset);
+            } else {
+                if (offset != position) {
+                    lseek(fd, offset, SEEK_SET);
+                }
+                n = read(fd, buffer.data(), length);
+                position = offset + (n > 0 ? n : 0);
+            }
+            if (n > 0) {
+                result.checksum += checksumBytes(buffer.data(), n);
+                result.bytes += n;
+            }
+            result.block_ns.push_back(nowNs() - start);
+        }
+        result.rss_kb = currentRSSKB();
+        close(fd);
+    } else if (api == "ifstream") {
+        std::ifstream in(path, std::ios::binary);
+        size_t position = 0;
+        for (size_t offset : offsets) {
+            size_t length = blockLength(offset);
+            unsigned long long start = nowNs();
+            if (offset != position) {
+                in.seekg(offset);
+            }
+            in.read(buffer.data(), length);
+            position = offset + in.gcount();
+            result.checksum += checksumBytes(buffer.data(), in.gcount());
+            result.bytes += in.gcount();
+            result.block_ns.push_back(nowNs() - start);
+        }
+        result.rss_kb = currentRSSKB();
+    } else {
+        throw std::runtime_error("Unknown API " + api);
+    }
+    return result;
+}
+
+static unsigned long long percentile(std::vector<unsigned long long>& samples, double fraction) {
+    if (samples.empty()) {
+        return 0;
+    }
+    size_t index = std::min(samples.size() - 1, static_cast<size_t>(fraction * samples.size()));
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+// Runs one configuration in the calling process
+static BenchNumbers measure(const BenchConfig& config, const std::string& path, size_t file_size,
+                            const std::string& api, const std::string& backend, const std::string& pattern) {
+    std::vector<size_t> offsets = blockOffsets(file_size, config.block_size, pattern);
+    for (int i = 0; i < config.warmup; ++i) {
+        runOnce(config, path, api, backend, offsets, file_size);
+    }
+
+    BenchNumbers result{ 0, 0, 0, 0, 0, 0, 0, 0 };
+    std::vector<unsigned long long> samples;
+    double total_mib_s = 0;
+    for (int i = 0; i < config.repeats; ++i) {
+        unsigned long long start = nowNs();
+        RunOutput run = runOnce(config, path, api, backend, offsets, file_size);
+        double seconds = (nowNs() - start) / 1e9;
+        double mib_s = run.bytes / seconds / (1 << 20);
+        result.best_mib_s = std::max(result.best_mib_s, mib_s);
+        total_mib_s += mib_s;
+        result.bytes_per_run = run.bytes;
+        result.checksum = run.checksum;
+        result.rss_kb = std::max(result.rss_kb, run.rss_kb);
+        samples.insert(samples.end(), run.block_ns.begin(), run.block_ns.end());
+    }
+    result.mean_mib_s = total_mib_s / std::max(1, config.repeats);
+    result.p50_ns = percentile(samples, 0.50);
+    result.p99_ns = percentile(samples, 0.99);
+    result.p999_ns = percentile(samples, 0.999);
+    return result;
+}
+
+// Runs one configuration in a forked child, so peak_rss_kb is that
+// configuration's peak (plus the parent's small footprint copied at fork)
+// rather than the monotonic peak of the whole sweep
+static BenchResult benchmark(const BenchConfig& config, const std::string& dataset, const std::string& path,
+                             size_t file_size, const std::string& api, const std::string& backend,
+                             const std::string& pattern) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        perror("pipe");
+        throw std::runtime_error("Failed to create the result pipe");
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error("Failed to fork the benchmark child");
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        try {
+            BenchNumbers numbers = measure(config, path, file_size, api, backend, pattern);
+            if (!writeAllBytes(fds[1], &numbers, sizeof(numbers))) {
+                _exit(1);
+            }
+        } catch (const std::exception& ex) {
+            std::cerr << "Error: " << ex.what() << "\n";
+            _exit(1);
+        }
+        close(fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    BenchNumbers numbers;
+    bool received = readAllBytes(fds[0], &numbers, sizeof(numbers));
+    close(fds[0]);
+    int status = 0;
+    struct rusage usage{};
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        perror("wait4");
+        throw std::runtime_error("Failed to wait for the benchmark child");
+    }
+    if (!received || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        throw std::runtime_error("Benchmark child failed for " + api + " on " + path);
+    }
+
+    // The kernel's high-water mark lags the RSS counters by a few pages
+    long peak_rss_kb = std::max(usage.ru_maxrss, numbers.rss_kb);
+    return BenchResult{ dataset, file_size, api, backend, pattern, numbers.bytes_per_run, numbers.best_mib_s,
+                        numbers.mean_mib_s, numbers.p50_ns, numbers.p99_ns, numbers.p999_ns, numbers.rss_kb,
+                        peak_rss_kb, numbers.checksum };
+}
+
+static void writeResults(const BenchConfig& config, const std::vector<BenchResult>& results, std::ostream& out) {
+    if (config.format == "csv") {
+        out << "dataset,file_size,api,backend,pattern,block_size,bytes_per_run,best_mib_s,mean_mib_s,"
+               "p50_ns,p99_ns,p999_ns,rss_kb,peak_rss_kb,checksum\n";
+        for (const BenchResult& r : results) {
+            out << r.dataset << "," << r.file_size << "," << r.api << "," << r.backend << "," << r.pattern << ","
+                << config.block_size << "," << r.bytes_per_run << "," << r.best_mib_s << ","
+                << r.mean_mib_s << "," << r.p50_ns << "," << r.p99_ns << "," << r.p999_ns << ","
+                << r.rss_kb << "," << r.peak_rss_kb << "," << r.checksum << "\n";
+        }
+        return;
+    }
+    out << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const BenchResult& r = results[i];
+        out << "  {\"dataset\": \"" << r.dataset << "\", \"file_size\": " << r.file_size
+            << ", \"api\": \"" << r.api << "\", \"backend\": \"" << r.backend
+            << "\", \"pattern\": \"" << r.pattern
+            << "\", \"block_size\": " << config.block_size << ", \"bytes_per_run\": " << r.bytes_per_run
+            << ", \"best_mib_s\": " << r.best_mib_s << ", \"mean_mib_s\": " << r.mean_mib_s
+            << ", \"p50_ns\": " << r.p50_ns << ", \"p99_ns\": " << r.p99_ns << ", \"p999_ns\": " << r.p999_ns
+            << ", \"rss_kb\": " << r.rss_kb << ", \"peak_rss_kb\": " << r.peak_rss_kb
+            << ", \"checksum\": " << r.checksum << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+}
+
+static void usage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+              << "  --sizes 16M,256M,4G       dataset sizes\n"
+              << "  --apis a,b,...            iterator,iterator-seqlock,iterator-immutable,readData,view,\n"
+              << "                            records,mmap,read,pread,ifstream\n"
+              << "  --patterns a,b            sequential,random\n"
+              << "  --backends a,b            library read backends: auto,mmap,io_uring (default auto)\n"
+              << "  --block BYTES             bytes per read / latency sample (default 4096)\n"
+              << "  --iterator-limit BYTES    bytes read by the byte iterator (default 8M)\n"
+              << "  --warmup N --repeats N    runs discarded / measured (default 1 / 3)\n"
+              << "  --dir DIR                 where datasets are generated (default .)\n"
+              << "  --lock FILE               lock file (default lockfile.lock)\n"
+              << "  --format json|csv --output FILE\n";
+}
+
+int main(int argc, char** argv) {
+    BenchConfig config;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+        std::string value = argv[++i];
+        if (arg == "--sizes") {
+            config.sizes.clear();
+            for (const std::string& size : splitList(value)) {
+                config.sizes.push_back(parseSize(size));
+            }
+        } else if (arg == "--apis") {
+            config.apis = splitList(value);
+        } else if (arg == "--patterns") {
+            config.patterns = splitList(value);
+        } else if (arg == "--backends") {
+            config.backends = splitList(value);
+        } else if (arg == "--block") {
+            config.block_size = parseSize(value);
+        } else if (arg == "--iterator-limit") {
+            config.iterator_limit = parseSize(value);
+        } else if (arg == "--warmup") {
+            config.warmup = std::stoi(value);
+        } else if (arg == "--repeats") {
+            config.repeats = std::stoi(value);
+        } else if (arg == "--dir") {
+            config.dir = value;
+        } else if (arg == "--lock") {
+            config.lock_path = value;
+        } else if (arg == "--format") {
+            config.format = value;
+        } else if (arg == "--output") {
+            config.output = value;
+        } else {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    try {
+        std::vector<BenchResult> results;
+        for (size_t size : config.sizes) {
+            for (const std::string dataset : { "binary", "text" }) {
+                std::string path = ensureDataset(config, dataset, size);
+                for (const std::string& api : config.apis) {
+                    for (const std::string& pattern : config.patterns) {
+                        // The cursor APIs only move forward
+                        bool cursor_api = api.compare(0, 8, "iterator") == 0 || api == "records";
+                        if (cursor_api && pattern != "sequential") {
+                            continue;
+                        }
+                        if (api == "records" && dataset != "text") {
+                            continue;
+                        }
+                        std::vector<std::string> backends = { "-" };
+                        if (libraryApi(api)) {
+                            backends = config.backends;
+                        }
+                        for (const std::string& backend : backends) {
+                            std::cerr << "[read-path] " << dataset << " " << size << " " << api << " "
+                                      << backend << " " << pattern << "\n";
+                            results.push_back(benchmark(config, dataset, path, size, api, backend, pattern));
+                        }
+                    }
+                }
+            }
+        }
+
+        if (config.output.empty()) {
+            writeResults(config, results, std::cout);
+        } else {
+            std::ofstream out(config.output);
+            writeResults(config, results, out);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,358 @@
+#include "column-convert.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <limits>
+#include <numeric>
+#include <string>
+#include <sys/mman.h>
+#include <type_traits>
+#include <unistd.h>
+#include <vector>
+
+#include "parallel-scan.h"
+
+// Values parsed at a time before narrowing them to the column type
+static constexpr size_t PARSE_BATCH = 4096;
+
+static inline bool isDigit(char c) {
+    return static_cast<unsigned char>(c - '0') <= 9;
+}
+
+// Store a parsed magnitude and sign; int64 takes -2^63 to 2^63 - 1, uint64
+// the whole magnitude range but no negative value
+static inline void storeInteger(std::uint64_t magnitude, bool negative, std::int64_t* value) {
+    std::uint64_t limit = static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max()) + (negative ? 1 : 0);
+    if (magnitude > limit) {
+        throw std::runtime_error("Integer out of the int64 range");
+    }
+    *value = negative ? static_cast<std::int64_t>(0 - magnitude) : static_cast<std::int64_t>(magnitude);
+}
+
+static inline void storeInteger(std::uint64_t magnitude, bool negative, std::uint64_t* value) {
+    if (negative && magnitude != 0) {
+        throw std::runtime_error("Negative integer out of the uint64 range");
+    }
+    *value = magnitude;
+}
+
+// Parse the digit run starting at p, with overflow checks; returns the end
+// of the run
+template <typename T>
+static const char* parseDigitsScalar(const char* p, const char* end, bool negative, T* value) {
+    std::uint64_t magnitude = 0;
+    for (; p < end && isDigit(*p); ++p) {
+        if (__builtin_mul_overflow(magnitude, 10, &magnitude)
+            || __builtin_add_overflow(magnitude, static_cast<std::uint64_t>(*p - '0'), &magnitude)) {
+            throw std::runtime_error(std::is_signed<T>::value ? "Integer out of the int64 range"
+                                                              : "Integer out of the uint64 range");
+        }
+    }
+    storeInteger(magnitude, negative, value);
+    return p;
+}
+
+template <typename T>
+static size_t parseIntegersScalar(const char** cursor, const char* end, T* out, size_t capacity) {
+    const char* p = *cursor;
+    size_t count = 0;
+    while (count < capacity) {
+        const char* start = p;
+        while (p < end && !isDigit(*p)) {
+            ++p;
+        }
+        if (p == end) {
+            break;
+        }
+        bool negative = p > start && p[-1] == '-';
+        p = parseDigitsScalar(p, end, negative, &out[count++]);
+    }
+    *cursor = p;
+    return count;
+}
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+// Tail of a vector count: previous says whether the byte before p was a digit
+static size_t countIntegersTail(const char* p, const char* end, bool previous) {
+    size_t count = 0;
+    for (; p < end; ++p) {
+        bool digit = isDigit(*p);
+        count += digit && !previous;
+        previous = digit;
+    }
+    return count;
+}
+
+// A value starts at every digit whose previous byte is not a digit
+__attribute__((target("avx2,popcnt")))
+static size_t countIntegersAvx2(const char* p, const char* end) {
+    const __m256i zero_char = _mm256_set1_epi8('0');
+    const __m256i nine = _mm256_set1_epi8(9);
+    size_t count = 0;
+    std::uint32_t carry = 0;  // 1 if the byte before p is a digit
+    for (; end - p >= 32; p += 32) {
+        __m256i v = _mm256_sub_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), zero_char);
+        std::uint32_t digits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(v, nine), v));
+        count += __builtin_popcount(digits & ~((digits << 1) | carry));
+        carry = digits >> 31;
+    }
+    return count + countIntegersTail(p, end, carry != 0);
+}
+
+static size_t countIntegersSse2(const char* p, const char* end) {
+    const __m128i zero_char = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    size_t count = 0;
+    std::uint32_t carry = 0;
+    for (; end - p >= 16; p += 16) {
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), zero_char);
+        std::uint32_t digits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v));
+        count += __builtin_popcount(digits & ~((digits << 1) | carry) & 0xffff);
+        carry = digits >> 15;
+    }
+    return count + countIntegersTail(p, end, carry != 0);
+}
+
+// With 16 bytes readable, a run of up to 15 digits is right-aligned in a
+// vector and reduced pairwise: 2 digits, 4, 8, then the two 8-digit halves
+template <typename T>
+__attribute__((target("sse4.1")))
+static size_t parseIntegersSse41(const char** cursor, const char* end, T* out, size_t capacity) {
+    const __m128i zero_char = _mm_set1_epi8('0');
+    const __m128i nine = _mm_set1_epi8(9);
+    const __m128i iota = _mm_setr_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i tens = _mm_setr_epi8(10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1, 10, 1);
+    const __m128i hundreds = _mm_setr_epi16(100, 1, 100, 1, 100, 1, 100, 1);
+    const __m128i ten_thousands = _mm_setr_epi16(10000, 1, 10000, 1, 10000, 1, 10000, 1);
+    const char* p = *cursor;
+    size_t count = 0;
+    while (count < capacity) {
+        // Skip to the next digit
+        const char* start = p;
+        unsigned int digits = 0;
+        for (; end - p >= 16; p += 16) {
+            __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), zero_char);
+            digits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v));
+            if (digits != 0) {
+                p += __builtin_ctz(digits);
+                break;
+            }
+        }
+        if (digits == 0) {
+            while (p < end && !isDigit(*p)) {
+                ++p;
+            }
+            if (p == end) {
+                break;
+            }
+        }
+        bool negative = p > start && p[-1] == '-';
+
+        if (end - p < 16) {
+            p = parseDigitsScalar(p, end, negative, &out[count++]);
+            continue;
+        }
+        __m128i v = _mm_sub_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), zero_char);
+        digits = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(v, nine), v));
+        int length = __builtin_ctz(~digits);
+        if (length >= 16) {
+            p = parseDigitsScalar(p, end, negative, &out[count++]);
+            continue;
+        }
+        // Byte i takes digit i - (16 - length); negative indices give zeros
+        v = _mm_shuffle_epi8(v, _mm_add_epi8(iota, _mm_set1_epi8(static_cast<char>(length - 16))));
+        __m128i pairs = _mm_maddubs_epi16(v, tens);
+        __m128i quads = _mm_madd_epi16(pairs, hundreds);
+        __m128i halves = _mm_madd_epi16(_mm_packus_epi32(quads, quads), ten_thousands);
+        std::uint64_t magnitude = static_cast<std::uint64_t>(_mm_cvtsi128_si32(halves)) * 100000000
+                                + static_cast<std::uint32_t>(_mm_extract_epi32(halves, 1));
+        storeInteger(magnitude, negative, &out[count++]);
+        p += length;
+    }
+    *cursor = p;
+    return count;
+}
+#else
+static size_t countIntegersScalar(const char* p, const char* end) {
+    size_t count = 0;
+    bool previous = false;
+    for (; p < end; ++p) {
+        bool digit = isDigit(*p);
+        count += digit && !previous;
+        previous = digit;
+    }
+    return count;
+}
+#endif
+
+struct IntegerParseDispatch {
+    size_t (*count)(const char*, const char*);
+    size_t (*parse)(const char**, const char*, std::int64_t*, size_t);
+    size_t (*parse_unsigned)(const char**, const char*, std::uint64_t*, size_t);
+    const char* name;
+};
+
+static IntegerParseDispatch selectIntegerParse() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.1")) {
+        if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+            return { countIntegersAvx2, parseIntegersSse41<std::int64_t>, parseIntegersSse41<std::uint64_t>,
+                     "avx2+sse4.1" };
+        }
+        return { countIntegersSse2, parseIntegersSse41<std::int64_t>, parseIntegersSse41<std::uint64_t>, "sse4.1" };
+    }
+    return { countIntegersSse2, parseIntegersScalar<std::int64_t>, parseIntegersScalar<std::uint64_t>, "sse2" };
+#else
+    return { countIntegersScalar, parseIntegersScalar<std::int64_t>, parseIntegersScalar<std::uint64_t>, "scalar" };
+#endif
+}
+
+// Resolved on first use, so callers from other static initializers are safe
+static const IntegerParseDispatch& integerParseDispatch() {
+    static const IntegerParseDispatch dispatch = selectIntegerParse();
+    return dispatch;
+}
+
+size_t countIntegers(const char* begin, const char* end) {
+    return integerParseDispatch().count(begin, end);
+}
+
+size_t parseIntegers(const char** cursor, const char* end, std::int64_t* out, size_t capacity) {
+    return integerParseDispatch().parse(cursor, end, out, capacity);
+}
+
+size_t parseUnsignedIntegers(const char** cursor, const char* end, std::uint64_t* out, size_t capacity) {
+    return integerParseDispatch().parse_unsigned(cursor, end, out, capacity);
+}
+
+const char* integerParseImplementation() {
+    return integerParseDispatch().name;
+}
+
+// Parse the expected number of values of text into out, narrowed to T
+template <typename T>
+static void parseChunk(std::string_view text, char* out, size_t expected, ColumnType type) {
+    const char* cursor = text.data();
+    const char* end = text.data() + text.size();
+    size_t done = 0;
+    if (std::is_same<T, std::int64_t>::value) {
+        // Same width: parse in place
+        done = parseIntegers(&cursor, end, reinterpret_cast<std::int64_t*>(out), expected);
+    } else if (std::is_same<T, std::uint64_t>::value) {
+        // Above INT64_MAX: only the unsigned parse takes the full range
+        done = parseUnsignedIntegers(&cursor, end, reinterpret_cast<std::uint64_t*>(out), expected);
+    } else {
+        std::int64_t batch[PARSE_BATCH];
+        while (done < expected) {
+            size_t parsed = parseIntegers(&cursor, end, batch, std::min(PARSE_BATCH, expected - done));
+            if (parsed == 0) {
+                break;
+            }
+            for (size_t i = 0; i < parsed; ++i) {
+                std::int64_t value = batch[i];
+                bool fits = value >= 0
+                    ? static_cast<std::uint64_t>(value) <= std::numeric_limits<T>::max()
+                    : std::is_signed<T>::value && value >= static_cast<std::int64_t>(std::numeric_limits<T>::min());
+                if (!fits) {
+                    throw std::runtime_error("Value " + std::to_string(value) + " does not fit in a "
+                                             + columnTypeName(type) + " column");
+                }
+                T narrowed = static_cast<T>(value);
+                memcpy(out + (done + i) * sizeof(T), &narrowed, sizeof(T));
+            }
+            done += parsed;
+        }
+    }
+    if (done != expected) {
+        throw std::runtime_error("Text changed during the conversion");
+    }
+}
+
+ColumnConvertResult convertToColumn(ZeroCopyRead& reader, const char* path, const ColumnConvertOptions& options) {
+    if (options.type == ColumnType::Float32 || options.type == ColumnType::Float64) {
+        throw std::invalid_argument("Only integer columns can be converted from text");
+    }
+    size_t element_size = columnElementSize(options.type);
+    ParallelScanOptions scan_options;
+    scan_options.threads = options.threads;
+    scan_options.chunk_size = options.chunk_size;
+    ParallelScanPlan plan = planParallelScan(reader, scan_options);
+    ParallelScanPin pin(reader, plan);  // Both passes read the same bytes
+
+    // Pass 1: values per chunk, so every chunk knows where its values go
+    std::vector<size_t> first_value(plan.chunk_count + 1, 0);
+    runWorkStealing(plan.chunk_count, plan.threads, [&](size_t, size_t index) {
+        ParallelScanChunk chunk = parallelScanChunk(reader, plan, index);
+        first_value[index + 1] = countIntegers(chunk.data.data(), chunk.data.data() + chunk.data.size());
+    });
+    std::partial_sum(first_value.begin(), first_value.end(), first_value.begin());
+
+    ColumnHeader header = makeColumnHeader(options.type, first_value.back(), options.alignment);
+    size_t file_size = header.data_offset + header.count * element_size;
+    // Built next to path and renamed over it: truncating the old file in
+    // place would fault readers that still have it mapped
+    std::string tmp_path = std::string(path) + ".tmp";
+    int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (fd == -1) {
+        perror("Failed to open column file");
+        throw std::runtime_error("Failed to open column file");
+    }
+    if (ftruncate(fd, file_size) == -1) {
+        perror("ftruncate failed");
+        close(fd);
+        unlink(tmp_path.c_str());
+        throw std::runtime_error("Failed to size column file");
+    }
+    void* map = mmap(nullptr, file_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        perror("mmap failed");
+        close(fd);
+        unlink(tmp_path.c_str());
+        throw std::runtime_error("Failed to mmap column file");
+    }
+    char* data = static_cast<char*>(map) + header.data_offset;
+
+    // Pass 2: parse every chunk straight into the mapping
+    try {
+        runWorkStealing(plan.chunk_count, plan.threads, [&](size_t, size_t index) {
+            ParallelScanChunk chunk = parallelScanChunk(reader, plan, index);
+            char* out = data + first_value[index] * element_size;
+            size_t expected = first_value[index + 1] - first_value[index];
+            switch (options.type) {
+                case ColumnType::Int32: parseChunk<std::int32_t>(chunk.data, out, expected, options.type); break;
+                case ColumnType::Int64: parseChunk<std::int64_t>(chunk.data, out, expected, options.type); break;
+                case ColumnType::UInt32: parseChunk<std::uint32_t>(chunk.data, out, expected, options.type); break;
+                case ColumnType::UInt64: parseChunk<std::uint64_t>(chunk.data, out, expected, options.type); break;
+                default: break;
+            }
+        });
+    } catch (...) {
+        munmap(map, file_size);
+        close(fd);
+        unlink(tmp_path.c_str());
+        throw;
+    }
+
+    // The header goes last, once the values are durable: until it is there
+    // the file is not a column. Only then does it replace path.
+    bool ok = msync(map, file_size, MS_SYNC) == 0;
+    memcpy(map, &header, sizeof(header));
+    ok = ok && msync(map, sizeof(header), MS_SYNC) == 0;
+    munmap(map, file_size);
+    close(fd);
+    if (!ok || rename(tmp_path.c_str(), path) != 0) {
+        perror("Failed to write column file");
+        unlink(tmp_path.c_str());
+        throw std::runtime_error("Failed to write column file");
+    }
+
+    ColumnConvertResult result;
+    result.count = header.count;
+    result.text_bytes = plan.size;
+    result.column_bytes = file_size;
+    return result;
+}
@@ -0,0 +1,161 @@
+#ifndef COLUMN_FORMAT_H
+#define COLUMN_FORMAT_H
+
+/*
+    * Column Format
+    * A self-describing file holding one column of fixed-width numbers: a
+    * 64-byte header, padding up to the data alignment, then the values back
+    * to back in native (little-endian) byte order.
+    *
+    *     magic | version | type | element_size | alignment | count | data_offset
+    *
+    * ColumnView<T> checks the header against T and maps the values as a
+    * TypedView, so a scan runs on the array in place. With the data aligned
+    * (64 bytes by default) alignedData() is always available.
+    *
+    *     ZeroCopyRead reader("values.col", "lockfile.lock");
+    *     ColumnView<int64_t> values(reader);
+    *     int64_t sum = std::accumulate(values.begin(), values.end(), int64_t(0));
+    *
+    * The header is written last, so a reader never takes a file that is still
+    * being converted for a complete column.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include "typed-view.h"
+#include "zero-copy-read-library.h"
+
+static constexpr std::uint64_t COLUMN_MAGIC = 0x31304c4f43435a5aULL; // "ZZCCOL01"
+static constexpr std::uint32_t COLUMN_VERSION = 1;
+static constexpr size_t COLUMN_DEFAULT_ALIGNMENT = 64;
+
+enum class ColumnType : std::uint32_t {
+    Int32 = 1,
+    Int64 = 2,
+    UInt32 = 3,
+    UInt64 = 4,
+    Float32 = 5,
+    Float64 = 6
+};
+
+struct ColumnHeader {
+    std::uint64_t magic;
+    std::uint32_t version;
+    std::uint32_t type;           // ColumnType
+    std::uint32_t element_size;   // Bytes per value
+    std::uint32_t alignment;      // data_offset is a multiple of it
+    std::uint64_t count;          // Number of values
+    std::uint64_t data_offset;    // File offset of the first value
+    std::uint8_t reserved[24];
+};
+
+static_assert(sizeof(ColumnHeader) == 64, "ColumnHeader is part of the file format");
+
+// ColumnType stored for values of T
+template <typename T> struct ColumnTypeOf;
+template <> struct ColumnTypeOf<std::int32_t> { static constexpr ColumnType value = ColumnType::Int32; };
+template <> struct ColumnTypeOf<std::int64_t> { static constexpr ColumnType value = ColumnType::Int64; };
+template <> struct ColumnTypeOf<std::uint32_t> { static constexpr ColumnType value = ColumnType::UInt32; };
+template <> struct ColumnTypeOf<std::uint64_t> { static constexpr ColumnType value = ColumnType::UInt64; };
+template <> struct ColumnTypeOf<float> { static constexpr ColumnType value = ColumnType::Float32; };
+template <> struct ColumnTypeOf<double> { static constexpr ColumnType value = ColumnType::Float64; };
+
+inline size_t columnElementSize(ColumnType type) {
+    switch (type) {
+        case ColumnType::Int32:
+        case ColumnType::UInt32:
+        case ColumnType::Float32:
+            return 4;
+        case ColumnType::Int64:
+        case ColumnType::UInt64:
+        case ColumnType::Float64:
+            return 8;
+    }
+    throw std::invalid_argument("Unknown column type");
+}
+
+inline const char* columnTypeName(ColumnType type) {
+    switch (type) {
+        case ColumnType::Int32: return "int32";
+        case ColumnType::Int64: return "int64";
+        case ColumnType::UInt32: return "uint32";
+        case ColumnType::UInt64: return "uint64";
+        case ColumnType::Float32: return "float32";
+        case ColumnType::Float64: return "float64";
+    }
+    return "unknown";
+}
+
+// Header for count values of type, the data aligned to alignment (a power
+// of two of at least 8)
+inline ColumnHeader makeColumnHeader(ColumnType type, std::uint64_t count, size_t alignment = COLUMN_DEFAULT_ALIGNMENT) {
+    if (alignment < 8 || (alignment & (alignment - 1)) != 0) {
+        throw std::invalid_argument("Column alignment must be a power of two of at least 8");
+    }
+    ColumnHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = COLUMN_MAGIC;
+    header.version = COLUMN_VERSION;
+    header.type = static_cast<std::uint32_t>(type);
+    header.element_size = static_cast<std::uint32_t>(columnElementSize(type));
+    header.alignment = static_cast<std::uint32_t>(alignment);
+    header.count = count;
+    header.data_offset = (sizeof(ColumnHeader) + alignment - 1) & ~(alignment - 1);
+    return header;
+}
+
+// Read and validate the header of a column file
+inline ColumnHeader readColumnHeader(ZeroCopyRead& reader) {
+    if (reader.getFileSize() < sizeof(ColumnHeader)) {
+        throw std::runtime_error("File is too small for a column header");
+    }
+    ColumnHeader header;
+    memcpy(&header, reader.view(0, sizeof(header)).data(), sizeof(header));
+    if (header.magic != COLUMN_MAGIC) {
+        throw std::runtime_error("Not a column file");
+    }
+    if (header.version != COLUMN_VERSION) {
+        throw std::runtime_error("Unsupported column file version");
+    }
+    if (header.element_size != columnElementSize(static_cast<ColumnType>(header.type))) {
+        throw std::runtime_error("Corrupt column header");
+    }
+    if (header.data_offset > reader.getFileSize()
+        || header.count > (reader.getFileSize() - header.data_offset) / header.element_size) {
+        throw std::runtime_error("Column file is shorter than its header says");
+    }
+    return header;
+}
+
+template <typename T>
+class ColumnView : public TypedView<T> {
+    private:
+        ColumnHeader header_;
+
+        ColumnView(ZeroCopyRead& reader, const ColumnHeader& header)
+            : TypedView<T>(reader, header.data_offset, header.count), header_(header) {}
+
+        static ColumnHeader checkedHeader(ZeroCopyRead& reader) {
+            ColumnHeader header = readColumnHeader(reader);
+            if (header.type != static_cast<std::uint32_t>(ColumnTypeOf<T>::value)) {
+                throw std::runtime_error("Column holds " + std::string(columnTypeName(static_cast<ColumnType>(header.type)))
+                                         + ", not " + columnTypeName(ColumnTypeOf<T>::value));
+            }
+            return header;
+        }
+
+    public:
+        // The values of the column file open in reader; throws if it does
+        // not hold values of T
+        explicit ColumnView(ZeroCopyRead& reader) : ColumnView(reader, checkedHeader(reader)) {}
+
+        const ColumnHeader& header() const { return header_; }
+};
+
+#endif // COLUMN_FORMAT_H
@@ -0,0 +1,282 @@
+#include "control-block.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <linux/futex.h>
+#include <poll.h>
+#include <stdexcept>
+#include <string>
+#include <sys/inotify.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/xattr.h>
+#include <thread>
+#include <unistd.h>
+
+// A sleeping reader re-checks the block at least this often, so a writer
+// that updates the block without waking (or crashes) cannot strand it
+static constexpr int MAX_SLEEP_MS = 100;
+// Adaptive spin budget bounds, in pause iterations
+static constexpr unsigned SPIN_MIN = 16;
+static constexpr unsigned SPIN_MAX = 1U << 14;
+static constexpr unsigned SPIN_INITIAL = 1U << 10;
+
+ControlBlock* mapControlBlock(int lock_fd) {
+    struct stat file_stat;
+    if (fstat(lock_fd, &file_stat) == -1) {
+        perror("fstat failed");
+        throw std::runtime_error("Failed to get lock file size");
+    }
+
+    // Never shrink the lock file: famfs lock files are created with a fixed
+    // size and another process may already have it mapped.
+    if (static_cast<size_t>(file_stat.st_size) < sizeof(ControlBlock)) {
+        if (ftruncate(lock_fd, sizeof(ControlBlock)) == -1) {
+            perror("ftruncate failed");
+            throw std::runtime_error("Failed to grow lock file");
+        }
+    }
+
+    void* ptr = mmap(nullptr, sizeof(ControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED, lock_fd, 0);
+    if (ptr == MAP_FAILED) {
+        perror("mmap failed");
+        throw std::runtime_error("Failed to mmap lock file");
+    }
+    return static_cast<ControlBlock*>(ptr);
+}
+
+void unmapControlBlock(ControlBlock* block) {
+    if (block != nullptr) {
+        munmap(block, sizeof(ControlBlock));
+    }
+}
+
+void claimControlBlock(ControlBlock* block) {
+    if (block->magic.load(std::memory_order_acquire) != CONTROL_BLOCK_MAGIC) {
+        block->sequence.store(0, std::memory_order_relaxed);
+        block->generation.store(0, std::memory_order_relaxed);
+        block->wake_word.store(0, std::memory_order_relaxed);
+        block->sleepers.store(0, std::memory_order_relaxed);
+        block->watchers.store(0, std::memory_order_relaxed);
+        block->flags.store(0, std::memory_order_relaxed);
+    }
+    block->sequence.fetch_and(~1ULL, std::memory_order_relaxed);
+}
+
+void publishFileIdentity(ControlBlock* block, int fd, std::uint64_t length, int notify_fd,
+                         std::uint32_t flags) {
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        perror("Failed to get file identity");
+        throw std::runtime_error("Failed to get file identity");
+    }
+    bool was_locked = block->sequence.load(std::memory_order_relaxed) & 1;
+    if (!was_locked) {
+        beginControlBlockWrite(block);
+    }
+    block->file_dev.store(file_stat.st_dev, std::memory_order_relaxed);
+    block->file_ino.store(file_stat.st_ino, std::memory_order_relaxed);
+    block->generation.fetch_add(1, std::memory_order_relaxed);
+    block->flags.store(flags, std::memory_order_relaxed);
+    block->magic.store(CONTROL_BLOCK_MAGIC, std::memory_order_release);
+    if (!was_locked) {
+        endControlBlockWrite(block, length, notify_fd);
+    } else {
+        block->committed_length.store(length, std::memory_order_relaxed);
+    }
+}
+
+bool writeSealMarker(int fd, std::uint64_t length) {
+    // The inode and size pin the marker to this file as sealed: a copy that
+    // kept the attribute, or a file rewritten or resized since, fails them
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        return false;
+    }
+    std::string value = std::to_string(length) + " " + std::to_string(file_stat.st_ino) + " "
+        + std::to_string(file_stat.st_size);
+    return fsetxattr(fd, SEAL_XATTR, value.data(), value.size(), 0) == 0;
+}
+
+bool readSealMarker(int fd, std::uint64_t* length) {
+    char value[96];
+    ssize_t size = fgetxattr(fd, SEAL_XATTR, value, sizeof(value) - 1);
+    if (size <= 0) {
+        return false;  // ENODATA: not sealed; ENOTSUP: no xattrs to carry a seal
+    }
+    value[size] = '\0';
+    std::uint64_t fields[3];  // Final length, inode, size at the seal
+    char* next = value;
+    for (std::uint64_t& field : fields) {
+        char* end;
+        field = strtoull(next, &end, 10);
+        if (end == next || (*end != ' ' && *end != '\0')) {
+            return false;
+        }
+        next = end;
+    }
+    if (*next != '\0') {
+        return false;
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1
+        || fields[1] != static_cast<std::uint64_t>(file_stat.st_ino)
+        || fields[2] != static_cast<std::uint64_t>(file_stat.st_size)
+        || fields[0] > fields[2]) {
+        return false;  // Stale: not the file, or not the contents, that were sealed
+    }
+    *length = fields[0];
+    return true;
+}
+
+bool clearSealMarker(int fd) {
+    return fremovexattr(fd, SEAL_XATTR) == 0 || errno == ENODATA || errno == ENOTSUP;
+}
+
+static long futex(std::atomic<std::uint32_t>* word, int op, std::uint32_t value, const struct timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+void wakeControlBlockSleepers(ControlBlock* block, int notify_fd) {
+    // Shared (not FUTEX_PRIVATE) futex: the sleepers are in other processes
+    futex(&block->wake_word, FUTEX_WAKE, INT_MAX, nullptr);
+    if (notify_fd >= 0 && block->watchers.load(std::memory_order_seq_cst) != 0) {
+        futimens(notify_fd, nullptr);  // Raises IN_ATTRIB on the lock file
+    }
+}
+
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+ControlBlockWaiter::ControlBlockWaiter(int lock_fd)
+    : lock_fd(lock_fd), inotify_fd(-1), use_futex(true),
+      spin_limit(std::thread::hardware_concurrency() > 1 ? SPIN_INITIAL : 0) {}
+
+ControlBlockWaiter::~ControlBlockWaiter() {
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+    }
+}
+
+template <typename Done>
+bool ControlBlockWaiter::spin(Done done) {
+    if (spin_limit == 0) {
+        return false; // Single CPU: the writer cannot run while we spin
+    }
+    for (unsigned i = 0; i < spin_limit; ++i) {
+        if (done()) {
+            spin_limit = std::min(spin_limit * 2, SPIN_MAX);
+            return true;
+        }
+        cpuRelax();
+    }
+    spin_limit = std::max(spin_limit / 2, SPIN_MIN);
+    return false;
+}
+
+bool ControlBlockWaiter::openWatch() {
+    if (inotify_fd >= 0) {
+        return true;
+    }
+    if (lock_fd < 0) {
+        return false;
+    }
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+        return false;
+    }
+    // Watch the file behind the descriptor, whatever path it was opened by
+    std::string path = "/proc/self/fd/" + std::to_string(lock_fd);
+    if (inotify_add_watch(inotify_fd, path.c_str(), IN_ATTRIB | IN_MODIFY) < 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+        lock_fd = -1;  // Do not try again
+        return false;
+    }
+    return true;
+}
+
+void ControlBlockWaiter::sleep(ControlBlock* block, std::uint32_t seen, int timeout_ms) {
+    if (timeout_ms < 0 || timeout_ms > MAX_SLEEP_MS) {
+        timeout_ms = MAX_SLEEP_MS;
+    }
+    if (use_futex) {
+        struct timespec timeout = { timeout_ms / 1000, (timeout_ms % 1000) * 1000000L };
+        block->sleepers.fetch_add(1, std::memory_order_seq_cst);
+        // Returns at once (EAGAIN) if the writer already moved the wake word
+        long ret = futex(&block->wake_word, FUTEX_WAIT, seen, &timeout);
+        int error = errno;
+        block->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        if (ret == 0 || error == EAGAIN || error == ETIMEDOUT || error == EINTR) {
+            return;
+        }
+        use_futex = false;  // e.g. ENOSYS, or a mapping the kernel cannot key
+    }
+    if (openWatch()) {
+        block->sleepers.fetch_add(1, std::memory_order_seq_cst);
+        block->watchers.fetch_add(1, std::memory_order_seq_cst);
+        if (block->wake_word.load(std::memory_order_seq_cst) == seen) {
+            struct pollfd pfd = { inotify_fd, POLLIN, 0 };
+            poll(&pfd, 1, timeout_ms);
+        }
+        block->watchers.fetch_sub(1, std::memory_order_seq_cst);
+        block->sleepers.fetch_sub(1, std::memory_order_seq_cst);
+        char events[4096];
+        while (read(inotify_fd, events, sizeof(events)) > 0) {
+        }
+        return;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeout_ms, 1)));
+}
+
+void ControlBlockWaiter::waitForUnlock(ControlBlock* block) {
+    auto unlocked = [block]() {
+        return (block->sequence.load(std::memory_order_acquire) & 1) == 0;
+    };
+    if (unlocked() || spin(unlocked)) {
+        return;
+    }
+    while (true) {
+        // Read the wake word before the sequence: an unlock after this load
+        // moves the word and the sleep returns at once
+        std::uint32_t seen = block->wake_word.load(std::memory_order_seq_cst);
+        if (unlocked()) {
+            return;
+        }
+        sleep(block, seen, MAX_SLEEP_MS);
+    }
+}
+
+bool ControlBlockWaiter::waitForCommit(ControlBlock* block, std::uint32_t seen, int timeout_ms) {
+    auto committed = [block, seen]() {
+        return block->wake_word.load(std::memory_order_acquire) != seen;
+    };
+    if (committed() || spin(committed)) {
+        return true;
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (!committed()) {
+        int remaining = -1;
+        if (timeout_ms >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) {
+                return false;
+            }
+            remaining = static_cast<int>(left);
+        }
+        sleep(block, seen, remaining);
+    }
+    return true;
+}
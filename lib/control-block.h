@@ -0,0 +1,166 @@
+#ifndef CONTROL_BLOCK_H
+#define CONTROL_BLOCK_H
+
+/*
+    * Control Block
+    * Fixed binary layout stored at the start of the lock file. The writer and
+    * the readers map it once (MAP_SHARED) and coordinate through atomic loads
+    * and stores on it instead of rewriting and re-reading a text lock file.
+    *
+    * sequence is a seqlock counter: it is odd while the writer is updating the
+    * data file and even otherwise. The writer publishes with release stores,
+    * readers validate with acquire loads.
+    *
+    * Readers that have to wait for the writer block on wake_word, a futex
+    * the writer bumps on every unlock. The writer only pays for a wakeup
+    * syscall while sleepers is nonzero, so the uncontended path stays free
+    * of syscalls on both sides.
+    *
+    * A writer that is done seals the file: CONTROL_BLOCK_SEALED is set in
+    * flags, committed_length becomes final, and the same length is stored
+    * on the data file itself (SEAL_XATTR) for readers that open it after
+    * the lock file was reused. Readers that see either stop coordinating.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <sys/types.h>
+
+static constexpr std::uint64_t CONTROL_BLOCK_MAGIC = 0x31304b434c52435aULL; // "ZCRLCK01"
+
+// ControlBlock::flags bits
+static constexpr std::uint32_t CONTROL_BLOCK_SEALED = 1;  // The data file will never change again
+
+// Extended attribute of a sealed data file: its final length, inode and size
+// at the seal, in decimal, separated by spaces
+static constexpr const char* SEAL_XATTR = "user.zero_copy.sealed";
+
+struct alignas(64) ControlBlock {
+    std::atomic<std::uint64_t> magic;
+    std::atomic<std::uint64_t> sequence;         // Seqlock counter, odd while writing
+    std::atomic<std::uint64_t> generation;       // Bumped when the data file is replaced
+    std::atomic<std::uint64_t> committed_length; // Bytes of the data file readers may use
+    std::atomic<std::uint64_t> file_dev;         // Identity of the data file being written
+    std::atomic<std::uint64_t> file_ino;
+    std::atomic<std::uint32_t> wake_word;        // Futex word, bumped on every unlock
+    std::atomic<std::uint32_t> sleepers;         // Readers blocked in the kernel
+    std::atomic<std::uint32_t> watchers;         // Sleepers waiting through inotify
+    std::atomic<std::uint32_t> flags;            // CONTROL_BLOCK_SEALED
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "ControlBlock requires lock-free 64-bit atomics to be shared between processes");
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t)
+              && std::atomic<std::uint32_t>::is_always_lock_free,
+              "ControlBlock::wake_word must be usable as a futex word");
+static_assert(sizeof(ControlBlock) == 64, "ControlBlock must fit in one cache line");
+
+// Map the control block at the start of the lock file, growing the file if it
+// is too small to hold one. Throws on failure.
+ControlBlock* mapControlBlock(int lock_fd);
+
+void unmapControlBlock(ControlBlock* block);
+
+// Writer side: take over the block, resetting it if it holds garbage (e.g.
+// the old text protocol) or a sequence left odd by a writer that crashed.
+void claimControlBlock(ControlBlock* block);
+
+// Writer side: publish the identity of the data file behind fd, its
+// committed length and its flags, bumping the generation. May be called
+// while locked. notify_fd is the writer's lock file descriptor, see
+// endControlBlockWrite.
+void publishFileIdentity(ControlBlock* block, int fd, std::uint64_t length, int notify_fd = -1,
+                         std::uint32_t flags = 0);
+
+// Writer side: wake the readers sleeping on the block. Futex sleepers are
+// woken directly; inotify watchers (where futexes do not work on the
+// mapping) are woken by touching notify_fd, the lock file.
+void wakeControlBlockSleepers(ControlBlock* block, int notify_fd);
+
+// Writer side seqlock: make the sequence odd before touching the data file...
+inline void beginControlBlockWrite(ControlBlock* block) {
+    std::uint64_t seq = block->sequence.load(std::memory_order_relaxed);
+    block->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+// ...then publish the new length and release the sequence, so readers that
+// acquire-load an even value also see everything written before it.
+// The wake word is bumped before sleepers is checked, and a reader registers
+// in sleepers before it re-checks the wake word, so no wakeup is lost.
+inline void endControlBlockWrite(ControlBlock* block, std::uint64_t length, int notify_fd = -1) {
+    block->committed_length.store(length, std::memory_order_relaxed);
+    std::uint64_t seq = block->sequence.load(std::memory_order_relaxed);
+    block->sequence.store(seq + 1, std::memory_order_release);
+    block->wake_word.fetch_add(1, std::memory_order_seq_cst);
+    if (block->sleepers.load(std::memory_order_seq_cst) != 0) {
+        wakeControlBlockSleepers(block, notify_fd);
+    }
+}
+
+// Whether a writer has initialized the block for the file identified by
+// (dev, ino). Readers of other files sharing the lock file ignore it.
+inline bool controlBlockOwnsFile(const ControlBlock* block, dev_t dev, ino_t ino) {
+    return block != nullptr
+        && block->magic.load(std::memory_order_acquire) == CONTROL_BLOCK_MAGIC
+        && block->file_dev.load(std::memory_order_relaxed) == static_cast<std::uint64_t>(dev)
+        && block->file_ino.load(std::memory_order_relaxed) == static_cast<std::uint64_t>(ino);
+}
+
+// Whether the writer sealed the file it published (see controlBlockOwnsFile)
+inline bool controlBlockSealed(const ControlBlock* block) {
+    return block != nullptr && (block->flags.load(std::memory_order_acquire) & CONTROL_BLOCK_SEALED);
+}
+
+// Store the seal marker (SEAL_XATTR) with the final length on the data file,
+// along with its inode and current size. Returns false where the filesystem
+// has no user extended attributes.
+bool writeSealMarker(int fd, std::uint64_t length);
+// Read the seal marker of the data file; false if it is not sealed, or if
+// the marker is stale: another inode, another size, or a final length past
+// the end of the file
+bool readSealMarker(int fd, std::uint64_t* length);
+// Remove the seal marker; true if the file has none left
+bool clearSealMarker(int fd);
+
+// Reader side wait strategy: spin briefly, then sleep on the futex until
+// the writer's next unlock. Where the mapping does not support futexes it
+// falls back to inotify on the lock file, and to short sleeps without one.
+// The spin budget adapts: it grows while spinning catches the unlock and
+// shrinks while it does not, and is zero on single-CPU machines.
+class ControlBlockWaiter {
+    private:
+        int lock_fd;            // Lock file watched by the inotify fallback, or -1
+        int inotify_fd;         // Created on first use
+        bool use_futex;         // Cleared when the kernel rejects the futex
+        unsigned spin_limit;    // Current spin budget in iterations
+
+        // Spin until done() or the budget runs out, adapting the budget
+        template <typename Done>
+        bool spin(Done done);
+        // Sleep once until the wake word moves past seen, or timeout_ms
+        void sleep(ControlBlock* block, std::uint32_t seen, int timeout_ms);
+        bool openWatch();
+
+    public:
+        explicit ControlBlockWaiter(int lock_fd = -1);
+        ~ControlBlockWaiter();
+
+        ControlBlockWaiter(const ControlBlockWaiter&) = delete;
+        ControlBlockWaiter& operator=(const ControlBlockWaiter&) = delete;
+
+        // Lock file for the inotify fallback, when it was opened after the
+        // waiter was constructed. The descriptor is borrowed.
+        void watchLockFile(int fd) { lock_fd = fd; }
+
+        // Block while the sequence is odd (the writer is mid-update)
+        void waitForUnlock(ControlBlock* block);
+        // Block until the writer unlocks after the wake word was seen, or
+        // until timeout_ms passes (-1 waits forever). Returns false on timeout.
+        bool waitForCommit(ControlBlock* block, std::uint32_t seen, int timeout_ms);
+
+        bool usesFutex() const { return use_futex; }
+        unsigned spinLimit() const { return spin_limit; }
+};
+
+#endif // CONTROL_BLOCK_H
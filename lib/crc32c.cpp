@@ -0,0 +1,78 @@
+#include "crc32c.h"
+
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+__attribute__((target("sse4.2")))
+static std::uint32_t crc32cSse42(const unsigned char* p, size_t size, std::uint32_t crc) {
+    std::uint64_t crc64 = crc;
+    for (; size >= 8; p += 8, size -= 8) {
+        std::uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = static_cast<std::uint32_t>(crc64);
+    for (; size > 0; ++p, --size) {
+        crc = _mm_crc32_u8(crc, *p);
+    }
+    return crc;
+}
+#endif
+
+// Reflected Castagnoli polynomial
+static constexpr std::uint32_t CRC32C_POLY = 0x82f63b78;
+
+struct Crc32cTable {
+    std::uint32_t entries[256];
+
+    Crc32cTable() {
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (crc & 1 ? CRC32C_POLY : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+};
+
+static std::uint32_t crc32cSoftware(const unsigned char* p, size_t size, std::uint32_t crc) {
+    static const Crc32cTable table;
+    for (; size > 0; ++p, --size) {
+        crc = table.entries[(crc ^ *p) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+using Crc32cFn = std::uint32_t (*)(const unsigned char*, size_t, std::uint32_t);
+
+struct Crc32cDispatch {
+    Crc32cFn fn;
+    const char* name;
+};
+
+static Crc32cDispatch selectCrc32c() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse4.2")) {
+        return { crc32cSse42, "sse4.2" };
+    }
+#endif
+    return { crc32cSoftware, "software" };
+}
+
+// Resolved on first use, so callers from other static initializers are safe
+static const Crc32cDispatch& crc32cDispatch() {
+    static const Crc32cDispatch dispatch = selectCrc32c();
+    return dispatch;
+}
+
+std::uint32_t crc32c(const void* data, size_t size, std::uint32_t crc) {
+    return ~crc32cDispatch().fn(static_cast<const unsigned char*>(data), size, ~crc);
+}
+
+const char* crc32cImplementation() {
+    return crc32cDispatch().name;
+}
@@ -0,0 +1,21 @@
+#ifndef CRC32C_H
+#define CRC32C_H
+
+/*
+    * CRC32C
+    * Castagnoli CRC of the framed records (frame-iterator.h). The SSE4.2
+    * crc32 instruction is used where the CPU has it, chosen once at runtime;
+    * elsewhere a table-driven software version gives the same result.
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C of [data, data + size). Pass the previous result as crc to extend
+// it: crc32c(b, nb, crc32c(a, na)) is the CRC of a followed by b.
+std::uint32_t crc32c(const void* data, size_t size, std::uint32_t crc = 0);
+
+// Name of the implementation selected for this CPU ("sse4.2", "software")
+const char* crc32cImplementation();
+
+#endif // CRC32C_H
@@ -0,0 +1,51 @@
+#ifndef FRAME_FORMAT_H
+#define FRAME_FORMAT_H
+
+/*
+    * Frame Format
+    * Length-prefixed, checksummed records written by WriteLibrary::writeFrame
+    * and read by FrameIterator (frame-iterator.h). Each frame is a 16-byte
+    * header followed by the payload, with no padding:
+    *
+    *     magic | length | type | crc | payload[length]
+    *
+    * All fields are little-endian uint32. type is free for the application
+    * (0 when unused). crc is the CRC32C of length, type and the payload, so a
+    * header or payload torn by a crashed writer does not verify. The next
+    * frame starts FRAME_HEADER_SIZE + length bytes later: a reader skips a
+    * frame without looking at its payload.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "crc32c.h"
+
+static constexpr std::uint32_t FRAME_MAGIC = 0x3146435a; // "ZCF1"
+
+struct FrameHeader {
+    std::uint32_t magic;
+    std::uint32_t length;   // Payload bytes
+    std::uint32_t type;
+    std::uint32_t crc;      // CRC32C of length, type and payload
+};
+
+static constexpr size_t FRAME_HEADER_SIZE = sizeof(FrameHeader);
+static_assert(FRAME_HEADER_SIZE == 16, "FrameHeader is part of the file format");
+
+inline std::uint32_t frameChecksum(std::uint32_t length, std::uint32_t type, const void* payload) {
+    std::uint32_t fields[2] = { length, type };
+    return crc32c(payload, length, crc32c(fields, sizeof(fields)));
+}
+
+inline FrameHeader makeFrameHeader(const void* payload, std::uint32_t length, std::uint32_t type) {
+    FrameHeader header;
+    header.magic = FRAME_MAGIC;
+    header.length = length;
+    header.type = type;
+    header.crc = frameChecksum(length, type, payload);
+    return header;
+}
+
+#endif // FRAME_FORMAT_H
@@ -0,0 +1,104 @@
+#include "frame-iterator.h"
+
+#include <algorithm>
+
+FrameIterator::FrameIterator()
+    : reader_(nullptr), result_(nullptr), window_offset(0), position(0) {}
+
+FrameIterator::FrameIterator(ZeroCopyRead& reader, size_t offset, const FrameReadOptions& options,
+                             FrameScanResult* result)
+    : reader_(&reader), options_(options), result_(result), window_offset(offset), position(offset) {
+    if (result_ != nullptr) {
+        *result_ = FrameScanResult();
+        result_->valid_end = offset;
+    }
+    advance();
+}
+
+void FrameIterator::finish(FrameStatus status) {
+    if (result_ != nullptr) {
+        result_->status = status;
+    }
+    reader_ = nullptr;
+}
+
+void FrameIterator::advance() {
+    if (reader_ == nullptr) {
+        return;
+    }
+    size_t size = reader_->getFileSize();
+    if (position + FRAME_HEADER_SIZE > size) {
+        size = reader_->refresh();  // Follow mode may have more data
+        if (position >= size) {
+            finish(FrameStatus::Ok);
+            return;
+        }
+        if (position + FRAME_HEADER_SIZE > size) {
+            finish(FrameStatus::Truncated);
+            return;
+        }
+    }
+
+    size_t needed = FRAME_HEADER_SIZE;
+    while (true) {
+        if (position < window_offset || position + needed > window_offset + window.size()) {
+            // One coordination check for the next window of frames
+            size_t window_size = std::max(RECORD_WINDOW_SIZE, needed);
+            window = reader_->view(position, std::min(window_size, size - position));
+            window_offset = position;
+            reader_->prefetchAhead(position);
+            if (window.size() < needed) {
+                finish(FrameStatus::Truncated);
+                return;
+            }
+        }
+
+        const char* start = window.data() + (position - window_offset);
+        FrameHeader header;
+        memcpy(&header, start, sizeof(header));
+        if (header.magic != FRAME_MAGIC) {
+            finish(FrameStatus::Corrupt);
+            return;
+        }
+        size_t frame_size = FRAME_HEADER_SIZE + header.length;
+        if (position + frame_size > size) {
+            size = reader_->refresh();
+            if (position + frame_size > size) {
+                finish(FrameStatus::Truncated);
+                return;
+            }
+        }
+        if (position + frame_size > window_offset + window.size()) {
+            // The frame runs past the window: map one that holds all of it
+            needed = frame_size;
+            window = std::string_view();
+            continue;
+        }
+
+        frame.payload = std::string_view(start + FRAME_HEADER_SIZE, header.length);
+        frame.type = header.type;
+        frame.crc = header.crc;
+        frame.offset = position;
+        if (options_.verify && !verifyFrame(frame)) {
+            finish(FrameStatus::Corrupt);
+            return;
+        }
+        position += frame_size;
+        if (result_ != nullptr) {
+            result_->frames++;
+            result_->valid_end = position;
+        }
+        return;
+    }
+}
+
+FrameScanResult verifyFrames(ZeroCopyRead& reader, size_t offset) {
+    FrameReadOptions options;
+    options.verify = true;
+    FrameRange range(reader, offset, options);
+    FrameIterator it = range.begin();
+    while (it != range.end()) {
+        ++it;
+    }
+    return range.result();
+}
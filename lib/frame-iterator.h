@@ -0,0 +1,139 @@
+#ifndef FRAME_ITERATOR_H
+#define FRAME_ITERATOR_H
+
+/*
+    * Frame Iterator
+    * Iterates over the checksummed frames of a ZeroCopyRead file
+    * (frame-format.h), yielding each payload as a view into the mapping. The
+    * length in the header leads straight to the next frame, so skipping a
+    * frame costs the same whatever its size. As with RecordIterator,
+    * coordination with the writer is checked once per window of
+    * RECORD_WINDOW_SIZE bytes.
+    *
+    *     FrameRange range = frames(reader);
+    *     for (const Frame& frame : range) { ... }
+    *     if (range.result().status != FrameStatus::Ok) {
+    *         // Torn or corrupt frame at range.result().valid_end
+    *     }
+    *
+    * Checksums are verified only when asked: per frame with verifyFrame(),
+    * for every frame with FrameReadOptions::verify, or for the whole file at
+    * once with verifyFrames(). Iteration stops at the first frame that is cut
+    * short by the end of the file (a writer crashed while writing it) or is
+    * not a frame at all; the result says which, and where the valid frames
+    * end.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+#include "frame-format.h"
+#include "record-iterator.h"
+#include "zero-copy-read-library.h"
+
+struct Frame {
+    std::string_view payload;   // View into the mapping
+    std::uint32_t type = 0;
+    std::uint32_t crc = 0;      // Checksum stored in the header
+    size_t offset = 0;          // File offset of the frame header
+};
+
+// Whether the checksum stored with frame matches its contents
+inline bool verifyFrame(const Frame& frame) {
+    return frameChecksum(static_cast<std::uint32_t>(frame.payload.size()), frame.type, frame.payload.data())
+        == frame.crc;
+}
+
+enum class FrameStatus {
+    Ok,         // Every frame up to the end of the file was read
+    Truncated,  // The last frame runs past the end of the file
+    Corrupt     // Bad magic, or a checksum mismatch when verifying
+};
+
+struct FrameScanResult {
+    FrameStatus status = FrameStatus::Ok;
+    size_t frames = 0;      // Frames yielded
+    size_t valid_end = 0;   // Offset just after the last good frame
+};
+
+struct FrameReadOptions {
+    // Verify every frame's checksum before yielding it
+    bool verify = false;
+};
+
+class FrameIterator {
+    private:
+        ZeroCopyRead* reader_;      // nullptr for the end iterator
+        FrameReadOptions options_;
+        FrameScanResult* result_;   // Updated as frames are read; may be nullptr
+        std::string_view window;    // Validated view of the file at window_offset
+        size_t window_offset;
+        size_t position;            // Offset of the frame after the current one
+        Frame frame;
+
+        // Read the frame at position, or become the end iterator
+        void advance();
+        void finish(FrameStatus status);
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = Frame;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Frame*;
+        using reference = const Frame&;
+
+        // End iterator
+        FrameIterator();
+        FrameIterator(ZeroCopyRead& reader, size_t offset, const FrameReadOptions& options,
+                      FrameScanResult* result = nullptr);
+
+        reference operator*() const { return frame; }
+        pointer operator->() const { return &frame; }
+
+        FrameIterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        bool operator==(const FrameIterator& other) const {
+            return reader_ == other.reader_ && (reader_ == nullptr || frame.offset == other.frame.offset);
+        }
+        bool operator!=(const FrameIterator& other) const { return !(*this == other); }
+};
+
+class FrameRange {
+    private:
+        ZeroCopyRead& reader_;
+        size_t offset_;
+        FrameReadOptions options_;
+        FrameScanResult result_;
+
+    public:
+        FrameRange(ZeroCopyRead& reader, size_t offset, const FrameReadOptions& options)
+            : reader_(reader), offset_(offset), options_(options) {
+            result_.valid_end = offset;
+        }
+
+        FrameRange(const FrameRange&) = delete;
+        FrameRange& operator=(const FrameRange&) = delete;
+
+        FrameIterator begin() { return FrameIterator(reader_, offset_, options_, &result_); }
+        FrameIterator end() const { return FrameIterator(); }
+
+        // Status of the last iteration, complete once it reached end()
+        const FrameScanResult& result() const { return result_; }
+};
+
+// Frames of reader starting at offset
+inline FrameRange frames(ZeroCopyRead& reader, size_t offset = 0,
+                         const FrameReadOptions& options = FrameReadOptions()) {
+    return FrameRange(reader, offset, options);
+}
+
+// Walk and verify every frame from offset to the end of the file: the valid
+// prefix, and why it ends there
+FrameScanResult verifyFrames(ZeroCopyRead& reader, size_t offset = 0);
+
+#endif // FRAME_ITERATOR_H
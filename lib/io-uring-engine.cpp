@@ -0,0 +1,351 @@
+#include "io-uring-engine.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <linux/io_uring.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+// Largest buffer the kernel registers as one fixed buffer
+static constexpr size_t MAX_REGISTERED_BUFFER = 1ULL << 30;
+
+struct IoUringEngine::Ring {
+    int fd = -1;
+    void* sq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    void* cq_ptr = MAP_FAILED;
+    size_t cq_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned unsubmitted = 0;    // SQEs queued but not passed to io_uring_enter yet
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) {
+            munmap(sqes, sqes_size);
+        }
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+            munmap(cq_ptr, cq_size);
+        }
+        if (sq_ptr != MAP_FAILED) {
+            munmap(sq_ptr, sq_size);
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+static int ioUringEnter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0);
+}
+
+// Set up a ring with room for entries SQEs, or return nullptr where
+// io_uring cannot be used
+IoUringEngine::Ring* IoUringEngine::openRing(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    int ring_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ring_fd < 0) {
+        return nullptr; // ENOSYS, or EPERM when disabled by sysctl or seccomp
+    }
+    IoUringEngine::Ring* ring = new IoUringEngine::Ring();
+    ring->fd = ring_fd;
+    // IORING_OP_READ (5.6) predates IORING_FEAT_FAST_POLL (5.7)
+    if (!(params.features & IORING_FEAT_FAST_POLL)) {
+        delete ring;
+        return nullptr;
+    }
+
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        ring->sq_size = ring->cq_size = std::max(ring->sq_size, ring->cq_size);
+    }
+    ring->sq_ptr = mmap(nullptr, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring_fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) {
+        delete ring;
+        return nullptr;
+    }
+    ring->cq_ptr = single_mmap
+        ? ring->sq_ptr
+        : mmap(nullptr, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+               ring_fd, IORING_OFF_CQ_RING);
+    ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    ring->sqes = static_cast<io_uring_sqe*>(mmap(nullptr, ring->sqes_size, PROT_READ | PROT_WRITE,
+                                                 MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+    if (ring->cq_ptr == MAP_FAILED || ring->sqes == MAP_FAILED) {
+        delete ring;
+        return nullptr;
+    }
+
+    char* sq = static_cast<char*>(ring->sq_ptr);
+    char* cq = static_cast<char*>(ring->cq_ptr);
+    ring->sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    ring->sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    ring->sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    ring->cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    ring->cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    ring->cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    return ring;
+}
+
+IoUringEngine::IoUringEngine(int fd, char* buffer, size_t capacity, const IoEngineOptions& options)
+    : fd(fd), buffer(buffer), capacity(capacity), options_(options), ring(nullptr),
+      registered(false), in_flight(0), short_read(false), loaded_prefix(0), bytes_read_(0) {
+    if (options_.block_size == 0 || options_.block_size > UINT32_MAX) {
+        throw std::runtime_error("Invalid io_uring block size");
+    }
+    options_.queue_depth = std::max(options_.queue_depth, 1U);
+    size_t blocks = (capacity + options_.block_size - 1) / options_.block_size;
+    loaded.assign(blocks, 0);
+    pending.assign(blocks, 0);
+    ring = openRing(options_.queue_depth);
+    registerBuffer();
+}
+
+IoUringEngine::~IoUringEngine() {
+    try {
+        while (in_flight > 0) {
+            reap(true);
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "io_uring: " << ex.what() << std::endl;
+    }
+    unregisterBuffer();
+    delete ring;
+}
+
+void IoUringEngine::registerBuffer() {
+    if (ring == nullptr || !options_.register_buffer || capacity == 0
+        || capacity > MAX_REGISTERED_BUFFER) {
+        return;
+    }
+    struct iovec region = { buffer, capacity };
+    // Pins the buffer; fails with ENOMEM past RLIMIT_MEMLOCK, which only
+    // costs the READ_FIXED shortcut
+    registered = syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, &region, 1) == 0;
+}
+
+void IoUringEngine::unregisterBuffer() {
+    if (registered) {
+        syscall(__NR_io_uring_register, ring->fd, IORING_UNREGISTER_BUFFERS, nullptr, 0);
+        registered = false;
+    }
+}
+
+size_t IoUringEngine::wanted(size_t block, size_t visible_size) const {
+    size_t start = block * options_.block_size;
+    size_t limit = std::min(visible_size, capacity);
+    return start >= limit ? 0 : std::min(options_.block_size, limit - start);
+}
+
+void IoUringEngine::submitRead(size_t block, size_t length) {
+    size_t offset = block * options_.block_size;
+    if (ring == nullptr) {
+        ssize_t n = pread(fd, buffer + offset, length, offset);
+        if (n < 0) {
+            perror("pread failed");
+            throw std::runtime_error("Failed to read data file");
+        }
+        loaded[block] = std::max<std::uint32_t>(loaded[block], n);
+        short_read = short_read || static_cast<size_t>(n) < length;
+        bytes_read_.fetch_add(n, std::memory_order_relaxed);
+        return;
+    }
+
+    unsigned tail = *ring->sq_tail;  // Only this thread produces SQEs
+    unsigned index = tail & *ring->sq_mask;
+    io_uring_sqe* sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = registered ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->fd = fd;
+    sqe->off = offset;
+    sqe->addr = reinterpret_cast<std::uint64_t>(buffer + offset);
+    sqe->len = length;
+    sqe->buf_index = 0;
+    sqe->user_data = block;
+    ring->sq_array[index] = index;
+    __atomic_store_n(ring->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ring->unsubmitted++;
+    pending[block] = length;
+    in_flight++;
+}
+
+void IoUringEngine::reap(bool wait) {
+    if (ring == nullptr) {
+        return;
+    }
+    while (ring->unsubmitted > 0 || wait) {
+        unsigned flags = wait ? IORING_ENTER_GETEVENTS : 0;
+        int ret = ioUringEnter(ring->fd, ring->unsubmitted, wait ? 1 : 0, flags);
+        if (ret < 0) {
+            if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+                continue;
+            }
+            perror("io_uring_enter failed");
+            throw std::runtime_error("Failed to submit reads");
+        }
+        ring->unsubmitted -= std::min<unsigned>(ret, ring->unsubmitted);
+        if (ring->unsubmitted == 0) {
+            break;
+        }
+    }
+
+    unsigned head = *ring->cq_head;
+    unsigned tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+    int error = 0;
+    for (; head != tail; ++head) {
+        const io_uring_cqe* cqe = &ring->cqes[head & *ring->cq_mask];
+        size_t block = cqe->user_data;
+        if (cqe->res < 0) {
+            error = -cqe->res;
+        } else {
+            loaded[block] = std::max<std::uint32_t>(loaded[block], cqe->res);
+            short_read = short_read || static_cast<std::uint32_t>(cqe->res) < pending[block];
+            bytes_read_.fetch_add(cqe->res, std::memory_order_relaxed);
+        }
+        pending[block] = 0;
+        in_flight--;
+    }
+    __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+    if (error != 0) {
+        errno = error;
+        perror("io_uring read failed");
+        throw std::runtime_error("Failed to read data file");
+    }
+}
+
+void IoUringEngine::updatePrefix() {
+    size_t prefix = loaded_prefix.load(std::memory_order_relaxed);
+    for (size_t block = prefix / options_.block_size; block < loaded.size(); ++block) {
+        prefix = block * options_.block_size + loaded[block];
+        if (loaded[block] < options_.block_size) {
+            break;
+        }
+    }
+    loaded_prefix.store(std::min(prefix, capacity), std::memory_order_release);
+}
+
+void IoUringEngine::load(size_t offset, size_t end, size_t visible_size) {
+    end = std::min(end, std::min(visible_size, capacity));
+    if (offset >= end) {
+        return;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    size_t first = offset / options_.block_size;
+    size_t last = (end - 1) / options_.block_size;
+    short_read = false;
+    while (true) {
+        bool missing = false;
+        for (size_t block = first; block <= last; ++block) {
+            size_t length = wanted(block, visible_size);
+            if (loaded[block] >= length) {
+                continue;
+            }
+            missing = true;
+            if (pending[block] == 0) {
+                // A read in flight may be shorter than what is visible now:
+                // it is resubmitted once it completes
+                if (in_flight >= options_.queue_depth) {
+                    reap(true);
+                }
+                submitRead(block, length);
+            }
+        }
+        if (!missing) {
+            break;
+        }
+        if (short_read) {
+            // The file ends before the length it was said to have
+            throw std::runtime_error("Data file is shorter than its visible size");
+        }
+        reap(ring != nullptr && in_flight > 0);
+    }
+
+    // Readahead past the range, as far as the queue allows, without waiting
+    size_t ahead_end = std::min(std::min(visible_size, capacity), end + options_.readahead);
+    if (options_.readahead > 0 && ahead_end > end) {
+        if (ring == nullptr) {
+            posix_fadvise(fd, end, ahead_end - end, POSIX_FADV_WILLNEED);
+        } else {
+            for (size_t block = last + 1; block * options_.block_size < ahead_end
+                     && in_flight < options_.queue_depth; ++block) {
+                size_t length = wanted(block, visible_size);
+                if (loaded[block] < length && pending[block] == 0) {
+                    submitRead(block, length);
+                }
+            }
+        }
+    }
+    reap(false);
+    updatePrefix();
+}
+
+void IoUringEngine::prefetch(size_t offset, size_t end, size_t visible_size) {
+    end = std::min(end, std::min(visible_size, capacity));
+    if (offset >= end) {
+        return;
+    }
+    if (ring == nullptr) {
+        posix_fadvise(fd, offset, end - offset, POSIX_FADV_WILLNEED);
+        return;
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t block = offset / options_.block_size; block * options_.block_size < end; ++block) {
+        size_t length = wanted(block, visible_size);
+        if (loaded[block] < length && pending[block] == 0) {
+            if (in_flight >= options_.queue_depth) {
+                reap(true);
+            }
+            submitRead(block, length);
+        }
+    }
+    reap(false);
+    updatePrefix();
+}
+
+void IoUringEngine::drain() {
+    std::lock_guard<std::mutex> guard(lock);
+    while (in_flight > 0) {
+        reap(true);
+    }
+    unregisterBuffer();
+}
+
+void IoUringEngine::resize(char* new_buffer, size_t new_capacity) {
+    drain();
+    std::lock_guard<std::mutex> guard(lock);
+    buffer = new_buffer;
+    capacity = new_capacity;
+    size_t blocks = (capacity + options_.block_size - 1) / options_.block_size;
+    loaded.resize(blocks, 0);
+    pending.resize(blocks, 0);
+    registerBuffer();
+    updatePrefix();
+}
+
+void IoUringEngine::reset(int new_fd) {
+    drain();
+    std::lock_guard<std::mutex> guard(lock);
+    fd = new_fd;
+    std::fill(loaded.begin(), loaded.end(), 0);
+    loaded_prefix.store(0, std::memory_order_release);
+    registerBuffer();
+}
@@ -0,0 +1,96 @@
+#ifndef IO_URING_ENGINE_H
+#define IO_URING_ENGINE_H
+
+/*
+    * io_uring Engine
+    * Reads a data file on demand into a buffer owned by the caller, for
+    * readers whose file is not on DAX (see storage-backend.h). The file is
+    * read in blocks of block_size with up to queue_depth reads in flight;
+    * the buffer is registered with the ring (READ_FIXED) when the kernel
+    * lets it be pinned. Every load also starts readahead past the range
+    * that completes in the background, so a sequential reader finds the
+    * next blocks already there.
+    *
+    * The ring is driven with raw syscalls (no liburing). Where io_uring is
+    * unavailable (old kernel, kernel.io_uring_disabled, seccomp) the same
+    * blocks are read with pread and readahead becomes posix_fadvise.
+    *
+    * Bytes the writer has committed never change, so a block stays valid
+    * once read; only a replaced file (reset()) invalidates the buffer.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+struct IoEngineOptions {
+    size_t block_size = 1024 * 1024;    // Bytes per read
+    unsigned queue_depth = 32;          // Reads in flight at most
+    size_t readahead = 2 * 1024 * 1024; // Bytes read ahead of each load; 0 disables it
+    bool register_buffer = true;        // Try READ_FIXED (pins the whole buffer)
+};
+
+class IoUringEngine {
+    private:
+        struct Ring;
+        static Ring* openRing(unsigned entries);
+
+        int fd;
+        char* buffer;
+        size_t capacity;                     // Bytes of buffer
+        IoEngineOptions options_;
+        Ring* ring;                          // nullptr: pread fallback
+        bool registered;                     // buffer is registered for READ_FIXED
+        std::vector<std::uint32_t> loaded;   // Valid bytes at the start of each block
+        std::vector<std::uint32_t> pending;  // Bytes requested by the read in flight, 0 if none
+        unsigned in_flight;
+        bool short_read;                     // A read returned less than requested
+        std::atomic<size_t> loaded_prefix;   // [0, loaded_prefix) is all in the buffer
+        std::atomic<std::uint64_t> bytes_read_;
+        std::mutex lock;
+
+        // Bytes of block that should be in the buffer when size bytes are visible
+        size_t wanted(size_t block, size_t visible_size) const;
+        void submitRead(size_t block, size_t length);
+        // Handle completions; wait for at least one if wait is set
+        void reap(bool wait);
+        void registerBuffer();
+        void unregisterBuffer();
+        void updatePrefix();
+
+    public:
+        IoUringEngine(int fd, char* buffer, size_t capacity,
+                      const IoEngineOptions& options = IoEngineOptions());
+        ~IoUringEngine();
+
+        IoUringEngine(const IoUringEngine&) = delete;
+        IoUringEngine& operator=(const IoUringEngine&) = delete;
+
+        // Whether [0, end) is already in the buffer; no locking
+        bool loadedUpTo(size_t end) const {
+            return end <= loaded_prefix.load(std::memory_order_acquire);
+        }
+
+        // Make [offset, end) of the buffer hold the file's bytes, then start
+        // readahead. visible_size bounds both: bytes past it may not be
+        // committed yet. Thread-safe.
+        void load(size_t offset, size_t end, size_t visible_size);
+        // Start reading [offset, end) without waiting for it. Thread-safe.
+        void prefetch(size_t offset, size_t end, size_t visible_size);
+
+        // Wait for the reads in flight and unregister the buffer, before it
+        // is moved or unmapped
+        void drain();
+        // The buffer moved or grew (follow mode); loaded blocks are kept
+        void resize(char* new_buffer, size_t new_capacity);
+        // The file was replaced: read everything again from new_fd
+        void reset(int new_fd);
+
+        bool usesIoUring() const { return ring != nullptr; }
+        bool usesRegisteredBuffer() const { return registered; }
+        std::uint64_t bytesRead() const { return bytes_read_.load(std::memory_order_relaxed); }
+};
+
+#endif // IO_URING_ENGINE_H
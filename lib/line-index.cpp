@@ -0,0 +1,155 @@
+#include "line-index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+#include <sys/stat.h>
+
+#include "simd-search.h"
+
+LineIndex::LineIndex(ZeroCopyRead& reader, const char* sidecar_path)
+    : reader_(reader), scanned_until(0) {
+    if (sidecar_path != nullptr) {
+        sidecar_path_ = sidecar_path;
+    }
+    if (sidecar_path_.empty() || !loadSidecar()) {
+        line_starts.assign(1, 0);
+        scanned_until = 0;
+    }
+}
+
+bool LineIndex::scanChunk() {
+    size_t size = reader_.getFileSize();
+    if (scanned_until >= size) {
+        size = reader_.refresh();  // Follow mode may have more data
+        if (scanned_until >= size) {
+            return false;
+        }
+    }
+    size_t length = std::min(LINE_INDEX_SCAN_CHUNK, size - scanned_until);
+    std::string_view chunk = reader_.view(scanned_until, length);
+    const char* begin = chunk.data();
+    const char* end = begin + chunk.size();
+    for (const char* p = findByte(begin, end, '\n'); p != end; p = findByte(p + 1, end, '\n')) {
+        line_starts.push_back(scanned_until + (p - begin) + 1);
+    }
+    scanned_until += chunk.size();
+    return !chunk.empty();
+}
+
+size_t LineIndex::tailLength() {
+    return scanned_until - line_starts.back();
+}
+
+bool LineIndex::ensureLine(size_t n) {
+    while (line_starts.size() - 1 <= n) {
+        if (!scanChunk()) {
+            // Only the unterminated tail can still be line n
+            return n == line_starts.size() - 1 && tailLength() > 0;
+        }
+    }
+    return true;
+}
+
+size_t LineIndex::lineCount() {
+    while (scanChunk()) {
+    }
+    return line_starts.size() - 1 + (tailLength() > 0 ? 1 : 0);
+}
+
+std::string_view LineIndex::line(size_t n) {
+    if (!ensureLine(n)) {
+        return std::string_view();
+    }
+    size_t start = line_starts[n];
+    size_t end = n + 1 < line_starts.size() ? line_starts[n + 1] - 1 : scanned_until;
+    return reader_.view(start, end - start);
+}
+
+std::string_view LineIndex::lines(size_t first, size_t count) {
+    if (count == 0 || !ensureLine(first)) {
+        return std::string_view();
+    }
+    ensureLine(first + count - 1);
+    size_t last = first + count;
+    size_t start = line_starts[first];
+    size_t end = last < line_starts.size() ? line_starts[last] : scanned_until;
+    return reader_.view(start, end - start);
+}
+
+size_t LineIndex::lineAt(size_t offset) {
+    while (scanned_until <= offset && scanChunk()) {
+    }
+    if (offset >= scanned_until) {
+        return lineCount();
+    }
+    auto next = std::upper_bound(line_starts.begin(), line_starts.end(), offset);
+    return (next - line_starts.begin()) - 1;
+}
+
+size_t LineIndex::indexedBytes() const {
+    return scanned_until;
+}
+
+bool LineIndex::loadSidecar() {
+    FILE* file = fopen(sidecar_path_.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::uint64_t header[2];  // magic, number of entries
+    bool ok = fread(header, sizeof(header), 1, file) == 1
+        && header[0] == LINE_INDEX_MAGIC && header[1] > 0;
+    if (ok) {
+        // The count comes from the file: it has to fit both in the sidecar
+        // and in the data file (at most one line start per byte, plus one)
+        struct stat sidecar_stat;
+        ok = fstat(fileno(file), &sidecar_stat) == 0
+            && header[1] <= (static_cast<std::uint64_t>(sidecar_stat.st_size) - sizeof(header)) / sizeof(std::uint64_t)
+            && header[1] <= reader_.getFileSize() + 1;
+    }
+    if (ok) {
+        line_starts.resize(header[1]);
+        ok = fread(line_starts.data(), sizeof(std::uint64_t), header[1], file) == header[1];
+    }
+    fclose(file);
+
+    // The index must still describe this file: it cannot extend past its end,
+    // line starts strictly increase, and the last indexed line must end with
+    // a newline
+    if (ok) {
+        std::uint64_t last = line_starts.back();
+        ok = line_starts.front() == 0 && last <= reader_.getFileSize()
+            && std::adjacent_find(line_starts.begin(), line_starts.end(),
+                                  std::greater_equal<std::uint64_t>()) == line_starts.end()
+            && (last == 0 || reader_.view(last - 1, 1) == "\n");
+    }
+    if (!ok) {
+        line_starts.clear();
+        return false;
+    }
+    scanned_until = line_starts.back();
+    return true;
+}
+
+void LineIndex::save() {
+    if (sidecar_path_.empty()) {
+        throw std::runtime_error("LineIndex has no sidecar path");
+    }
+    std::string tmp_path = sidecar_path_ + ".tmp";
+    FILE* file = fopen(tmp_path.c_str(), "wb");
+    if (file == nullptr) {
+        perror("Failed to open sidecar");
+        throw std::runtime_error("Failed to open sidecar");
+    }
+    // Only complete lines are saved; the tail is rescanned on load
+    std::uint64_t header[2] = { LINE_INDEX_MAGIC, line_starts.size() };
+    bool ok = fwrite(header, sizeof(header), 1, file) == 1
+        && fwrite(line_starts.data(), sizeof(std::uint64_t), line_starts.size(), file) == line_starts.size();
+    ok = (fclose(file) == 0) && ok;
+    if (!ok || rename(tmp_path.c_str(), sidecar_path_.c_str()) != 0) {
+        perror("Failed to write sidecar");
+        unlink(tmp_path.c_str());
+        throw std::runtime_error("Failed to write sidecar");
+    }
+}
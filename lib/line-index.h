@@ -0,0 +1,66 @@
+#ifndef LINE_INDEX_H
+#define LINE_INDEX_H
+
+/*
+    * Line Index
+    * Offsets of the newline-terminated records in a ZeroCopyRead file, built
+    * lazily: the file is only scanned as far as the requested line, one
+    * coordination check per scanned chunk. Lines are returned as views into
+    * the reader's mapping. The index can be persisted in a sidecar file so a
+    * later process does not have to scan again.
+*/
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "zero-copy-read-library.h"
+
+static constexpr std::uint64_t LINE_INDEX_MAGIC = 0x31305844494e4c5aULL; // "ZLNIDX01"
+static constexpr size_t LINE_INDEX_SCAN_CHUNK = 1 << 20;
+
+class LineIndex {
+    private:
+        ZeroCopyRead& reader_;
+        std::string sidecar_path_;
+        // Start offset of every complete line, plus the offset just past the
+        // last newline seen (the start of the line being scanned)
+        std::vector<std::uint64_t> line_starts;
+        size_t scanned_until;          // Bytes of the file scanned so far
+
+        // Scan forward until line n is complete or the file ends.
+        // Returns false if line n does not exist.
+        bool ensureLine(size_t n);
+        // Scan one chunk; returns false at end of file
+        bool scanChunk();
+        // Length of the unterminated tail after the last newline
+        size_t tailLength();
+        bool loadSidecar();
+
+    public:
+        // sidecar_path: optional file to load the index from and save it to
+        explicit LineIndex(ZeroCopyRead& reader, const char* sidecar_path = nullptr);
+
+        // Number of lines, scanning the rest of the file if needed. A trailing
+        // line without a newline counts as a line.
+        size_t lineCount();
+
+        // Line n without its newline. Empty if it does not exist.
+        std::string_view line(size_t n);
+
+        // Lines [first, first + count) as one contiguous view, newlines
+        // included. Truncated at the end of the file.
+        std::string_view lines(size_t first, size_t count);
+
+        // Number of the line containing byte `offset`
+        size_t lineAt(size_t offset);
+
+        // Bytes of the file covered by the index so far
+        size_t indexedBytes() const;
+
+        // Write the index to the sidecar file (atomically, via rename)
+        void save();
+};
+
+#endif // LINE_INDEX_H
@@ -0,0 +1,122 @@
+#include "mapped-write-library.h"
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedWriteLibrary::MappedWriteLibrary(const char* file_path, const char* lock_file_path,
+                                       const MappedWriteOptions& options)
+    : committed_length(0), file_path_(file_path), lock_file_path_(lock_file_path) {
+    fd = open(file_path_.c_str(), O_RDWR);
+    if (fd < 0) {
+        perror("Failed to open data file");
+        throw std::runtime_error("Failed to open data file");
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        perror("Failed to get file size");
+        close(fd);
+        throw std::runtime_error("Failed to get file size");
+    }
+    capacity = file_stat.st_size;
+    if (capacity == 0) {
+        close(fd);
+        throw std::runtime_error("Mapped writer needs a preallocated data file");
+    }
+
+    lock_fd = open(lock_file_path_.c_str(), O_RDWR);
+    if (lock_fd < 0) {
+        perror("Failed to open lock file");
+        close(fd);
+        throw std::runtime_error("Failed to open lock file");
+    }
+
+    void* ptr = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ptr == MAP_FAILED) {
+        perror("mmap failed");
+        close(fd);
+        close(lock_fd);
+        throw std::runtime_error("Failed to mmap data file");
+    }
+    base_mmap_ptr = static_cast<char*>(ptr);
+
+    try {
+        control_block = mapControlBlock(lock_fd);
+    } catch (...) {
+        munmap(base_mmap_ptr, capacity);
+        close(fd);
+        close(lock_fd);
+        throw;
+    }
+    if (controlBlockOwnsFile(control_block, file_stat.st_dev, file_stat.st_ino)) {
+        committed_length = control_block->committed_length.load(std::memory_order_relaxed);
+        if (committed_length > capacity) {
+            committed_length = 0; // Stale: the file was recreated under the same inode
+        }
+    }
+    claimControlBlock(control_block);
+    publishFileIdentity(control_block, fd, committed_length, lock_fd);
+
+    flush_method = detectFlushMethod();
+    flush_enabled = options.persist != PersistMode::None;
+    if (options.persist == PersistMode::Msync) {
+        flush_method = FlushMethod::Msync;
+    } else if (options.persist == PersistMode::CacheLineFlush && flush_method == FlushMethod::Msync) {
+        std::cerr << "Warning: no cache-line flush instruction, falling back to msync" << std::endl;
+    }
+}
+
+MappedWriteLibrary::~MappedWriteLibrary() {
+    unmapControlBlock(control_block);
+    munmap(base_mmap_ptr, capacity);
+    close(fd);
+    close(lock_fd);
+}
+
+void MappedWriteLibrary::writeData(const char* data, size_t size) {
+    if (size > capacity - committed_length) {
+        throw std::runtime_error("Mapped data file is full");
+    }
+
+    beginControlBlockWrite(control_block);
+    char* dst = base_mmap_ptr + committed_length;
+    if (flush_enabled) {
+        nonTemporalCopy(dst, data, size, flush_method);
+        // Payload must reach memory before the new length is visible
+        persistFence();
+    } else {
+        memcpy(dst, data, size);
+    }
+    committed_length += size;
+    endControlBlockWrite(control_block, committed_length, lock_fd);
+    counters_.write_calls.add();
+    counters_.batch_writes.add();
+    counters_.bytes_written.add(size);
+    if (flush_enabled) {
+        counters_.syncs.add();
+    }
+
+    if (flush_enabled) {
+        // Make the control block update durable as well; it is a separate
+        // mapping of the lock file, so the msync fallback needs its own call
+        flushRange(control_block, sizeof(ControlBlock), flush_method);
+        persistFence();
+    }
+}
+
+size_t MappedWriteLibrary::getCommittedLength() const {
+    return committed_length;
+}
+
+size_t MappedWriteLibrary::getCapacity() const {
+    return capacity;
+}
+
+const char* MappedWriteLibrary::getFlushMethodName() const {
+    return flush_enabled ? flushMethodName(flush_method) : "none";
+}
@@ -0,0 +1,69 @@
+#ifndef MAPPED_WRITE_LIBRARY_H
+#define MAPPED_WRITE_LIBRARY_H
+
+/*
+    * Mapped Write Library
+    * Alternative to WriteLibrary for files on DAX/CXL mounts. The data file is
+    * mapped MAP_SHARED and payloads are stored directly into it with
+    * non-temporal stores, flushed with clwb/clflushopt + sfence (msync where no
+    * cache-line flush exists), and published by atomically advancing the
+    * committed length in the control block. No syscall is made per message.
+    *
+    * The file is not grown: its size at open time is the capacity (e.g. a
+    * famfs file created with `famfs creat -s`).
+*/
+
+#include <cstdint>
+#include <string>
+
+#include "control-block.h"
+#include "persist.h"
+#include "stats.h"
+
+enum class PersistMode {
+    Auto,            // Cache-line flush if the CPU has one, msync otherwise
+    CacheLineFlush,  // clwb / clflushopt / clflush + sfence
+    Msync,           // msync the written pages
+    None             // Rely on cache coherence only (tmpfs, benchmarking)
+};
+
+struct MappedWriteOptions {
+    PersistMode persist = PersistMode::Auto;
+};
+
+class MappedWriteLibrary {
+    private:
+        int fd;                        // File descriptor for the data file
+        int lock_fd;                   // File descriptor for the lock file
+        size_t capacity;               // Mapped size of the data file
+        size_t committed_length;       // Bytes published to readers
+        char* base_mmap_ptr;
+        ControlBlock* control_block;
+        FlushMethod flush_method;
+        bool flush_enabled;
+        std::string file_path_;
+        std::string lock_file_path_;
+        WriterCounters counters_;
+
+    public:
+        // A committed length already published in the control block for this
+        // file is resumed; otherwise the whole file is treated as free space.
+        MappedWriteLibrary(const char* file_path, const char* lock_file_path,
+                           const MappedWriteOptions& options = MappedWriteOptions());
+        ~MappedWriteLibrary();
+
+        // Store data after the committed length, persist it and publish the
+        // new length. Throws if the file has no room left.
+        void writeData(const char* data, size_t size);
+
+        size_t getCommittedLength() const;
+        size_t getCapacity() const;
+        // Flush method in use, or "none"
+        const char* getFlushMethodName() const;
+
+        // Snapshot of the hot-path counters (stats.h); syncs counts the
+        // flush rounds of writeData
+        WriterStats stats() const { return counters_.snapshot(); }
+};
+
+#endif // MAPPED_WRITE_LIBRARY_H
@@ -0,0 +1,172 @@
+#include "parallel-scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "simd-search.h"
+
+static constexpr size_t MIN_AUTO_CHUNK_SIZE = 64 << 10;
+static constexpr size_t MAX_AUTO_CHUNK_SIZE = 16 << 20;
+static constexpr size_t AUTO_CHUNKS_PER_THREAD = 8;
+
+ParallelScanPlan planParallelScan(ZeroCopyRead& reader, const ParallelScanOptions& options) {
+    ParallelScanPlan plan;
+    // Workers only read below the snapshot, where views skip coordination:
+    // concurrent views never race on the lock waiter, fd or the mapping
+    plan.owns_snapshot = reader.getSnapshotLength() == 0;
+    plan.size = reader.snapshot().length;
+    plan.delimiter = options.delimiter;
+
+    size_t threads = options.threads;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    plan.chunk_size = options.chunk_size;
+    if (plan.chunk_size == 0) {
+        plan.chunk_size = std::clamp(plan.size / (threads * AUTO_CHUNKS_PER_THREAD),
+                                     MIN_AUTO_CHUNK_SIZE, MAX_AUTO_CHUNK_SIZE);
+    }
+    plan.chunk_count = (plan.size + plan.chunk_size - 1) / plan.chunk_size;
+    // No point in starting workers that would find nothing to do
+    plan.threads = std::max<size_t>(1, std::min(threads, plan.chunk_count));
+    return plan;
+}
+
+ParallelScanChunk parallelScanChunk(ZeroCopyRead& reader, const ParallelScanPlan& plan, size_t index) {
+    size_t nominal_start = index * plan.chunk_size;
+    size_t nominal_end = std::min(plan.size, nominal_start + plan.chunk_size);
+
+    // One view covers the chunk and the search for both boundaries unless a
+    // record is longer than a chunk
+    size_t window_offset = nominal_start == 0 ? 0 : nominal_start - 1;
+    std::string_view window = reader.view(window_offset,
+                                          std::min(plan.size - window_offset, 2 * plan.chunk_size + 1));
+
+    // Offset just past the first delimiter at or after nominal - 1, so that
+    // a chunk starting right after a delimiter keeps its first record
+    auto boundary = [&](size_t nominal) -> size_t {
+        if (nominal == 0 || nominal >= plan.size) {
+            return std::min(nominal, plan.size);
+        }
+        size_t from = nominal - 1;
+        while (from < plan.size) {
+            if (from < window_offset || from >= window_offset + window.size()) {
+                window = reader.view(from, std::min(plan.size - from, plan.chunk_size));
+                window_offset = from;
+                if (window.empty()) {
+                    break;
+                }
+            }
+            const char* begin = window.data() + (from - window_offset);
+            const char* end = window.data() + window.size();
+            const char* found = findByte(begin, end, plan.delimiter);
+            if (found != end) {
+                return window_offset + (found - window.data()) + 1;
+            }
+            from = window_offset + window.size();
+        }
+        return plan.size;
+    };
+
+    size_t start = boundary(nominal_start);
+    size_t end = std::max(start, boundary(nominal_end));
+    if (start == end) {
+        return { start, std::string_view() };
+    }
+    if (start >= window_offset && end <= window_offset + window.size()) {
+        return { start, window.substr(start - window_offset, end - start) };
+    }
+    return { start, reader.view(start, end - start) };
+}
+
+namespace {
+
+// Remaining tasks [next, end) of one worker
+struct alignas(64) WorkQueue {
+    std::mutex lock;
+    size_t next = 0;
+    size_t end = 0;
+};
+
+bool popTask(WorkQueue& queue, size_t& task) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.next >= queue.end) {
+        return false;
+    }
+    task = queue.next++;
+    return true;
+}
+
+// Take the back half of the first non-empty queue after our own. The
+// first stolen task is returned, the rest go to our (empty) queue.
+bool stealTask(std::vector<WorkQueue>& queues, size_t self, size_t& task) {
+    for (size_t i = 1; i < queues.size(); ++i) {
+        WorkQueue& victim = queues[(self + i) % queues.size()];
+        size_t stolen_begin;
+        size_t stolen_end;
+        {
+            std::lock_guard<std::mutex> guard(victim.lock);
+            size_t remaining = victim.end - victim.next;
+            if (remaining == 0) {
+                continue;
+            }
+            stolen_end = victim.end;
+            stolen_begin = stolen_end - (remaining + 1) / 2;
+            victim.end = stolen_begin;
+        }
+        WorkQueue& own = queues[self];
+        std::lock_guard<std::mutex> guard(own.lock);
+        own.next = stolen_begin + 1;
+        own.end = stolen_end;
+        task = stolen_begin;
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+void runWorkStealing(size_t task_count, size_t threads,
+                     const std::function<void(size_t worker, size_t task)>& run) {
+    threads = std::max<size_t>(1, threads);
+    std::vector<WorkQueue> queues(threads);
+    for (size_t w = 0; w < threads; ++w) {
+        queues[w].next = task_count * w / threads;
+        queues[w].end = task_count * (w + 1) / threads;
+    }
+
+    std::atomic<bool> failed(false);
+    std::exception_ptr error;
+    std::mutex error_lock;
+    auto work = [&](size_t worker) {
+        size_t task;
+        try {
+            while (!failed.load(std::memory_order_relaxed)
+                   && (popTask(queues[worker], task) || stealTask(queues, worker, task))) {
+                run(worker, task);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(error_lock);
+            if (!error) {
+                error = std::current_exception();
+            }
+            failed.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (size_t w = 1; w < threads; ++w) {
+        pool.emplace_back(work, w);
+    }
+    work(0);
+    for (std::thread& thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
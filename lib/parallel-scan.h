@@ -0,0 +1,124 @@
+#ifndef PARALLEL_SCAN_H
+#define PARALLEL_SCAN_H
+
+/*
+    * Parallel Scan
+    * Split a ZeroCopyRead file into delimiter-aligned chunks and hand them to
+    * a work-stealing thread pool. Each chunk is one view() of the mapping, so
+    * coordination with the writer is checked once per chunk, and every
+    * worker accumulates into its own partial result. The partials are merged
+    * on the calling thread once all chunks are done.
+    *
+    *     size_t lines = parallelScan<size_t>(reader,
+    *         [](size_t& count, std::string_view chunk, size_t) {
+    *             count += std::count(chunk.begin(), chunk.end(), '\n');
+    *         },
+    *         [](size_t& total, const size_t& count) { total += count; });
+    *
+    * A chunk ends just after a delimiter (or at the end of the file), so no
+    * record is split between two chunks. A record longer than a chunk makes
+    * the chunk larger rather than splitting it.
+    *
+    * The scan covers the bytes committed when it starts, pinned with a
+    * snapshot() of the reader. Every view the workers take ends below the
+    * watermark, so none of them touches the reader's coordination state (lock
+    * waiter, file descriptor, mapping): the writer may append, unlock or seal
+    * while the scan runs. The snapshot is released when the scan ends, unless
+    * the caller already held one (it is then moved forward). Other threads
+    * must not use the reader while the scan runs.
+*/
+
+#include <cstddef>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "zero-copy-read-library.h"
+
+struct ParallelScanOptions {
+    size_t threads = 0;      // 0 uses every hardware thread
+    size_t chunk_size = 0;   // 0 picks about 8 chunks per thread, 64 KiB to 16 MiB
+    char delimiter = '\n';
+};
+
+struct ParallelScanPlan {
+    size_t size;            // Snapshot length: the scan reads below it only
+    size_t chunk_size;
+    size_t chunk_count;
+    size_t threads;
+    char delimiter;
+    bool owns_snapshot;     // The reader had no snapshot before the plan
+};
+
+struct ParallelScanChunk {
+    size_t offset;
+    std::string_view data;  // Empty if a longer record covers the whole chunk
+};
+
+// Pin the scanned size with a snapshot of the reader, then fix the chunk
+// size and the number of workers. Hold a ParallelScanPin while the chunks
+// are read.
+ParallelScanPlan planParallelScan(ZeroCopyRead& reader, const ParallelScanOptions& options);
+
+// Releases the snapshot taken by planParallelScan when the scan ends,
+// exceptions included
+class ParallelScanPin {
+    private:
+        ZeroCopyRead& reader_;
+        bool release_;
+
+    public:
+        ParallelScanPin(ZeroCopyRead& reader, const ParallelScanPlan& plan)
+            : reader_(reader), release_(plan.owns_snapshot) {}
+        ~ParallelScanPin() {
+            if (release_) {
+                reader_.releaseSnapshot();
+            }
+        }
+
+        ParallelScanPin(const ParallelScanPin&) = delete;
+        ParallelScanPin& operator=(const ParallelScanPin&) = delete;
+};
+
+// Delimiter-aligned chunk number `index` of the plan
+ParallelScanChunk parallelScanChunk(ZeroCopyRead& reader, const ParallelScanPlan& plan, size_t index);
+
+// Run run(worker, task) for every task in [0, task_count) on `threads`
+// workers, the calling thread included. Each worker starts with a contiguous
+// range of tasks and steals half of another worker's remaining range when
+// its own runs out. The first exception thrown by a task is rethrown here.
+void runWorkStealing(size_t task_count, size_t threads,
+                     const std::function<void(size_t worker, size_t task)>& run);
+
+// fn(Partial& partial, std::string_view chunk, size_t chunk_offset) for every
+// chunk; merge(Partial& total, const Partial& partial) for every worker.
+template <typename Partial, typename Fn, typename Merge>
+Partial parallelScan(ZeroCopyRead& reader, Fn fn, Merge merge,
+                     const ParallelScanOptions& options = ParallelScanOptions()) {
+    // Padded so that workers updating their partials do not share cache lines
+    struct alignas(64) Slot {
+        Partial value = Partial();
+    };
+
+    ParallelScanPlan plan = planParallelScan(reader, options);
+    ParallelScanPin pin(reader, plan);
+    std::vector<Slot> partials(plan.threads);
+    runWorkStealing(plan.chunk_count, plan.threads, [&](size_t worker, size_t index) {
+        ParallelScanChunk chunk = parallelScanChunk(reader, plan, index);
+        if (!chunk.data.empty()) {
+            if (reader.getPrefetchDistance() != 0) {
+                // Fault the chunk in with one call instead of page by page
+                reader.prefetch(chunk.offset, chunk.data.size());
+            }
+            fn(partials[worker].value, chunk.data, chunk.offset);
+        }
+    });
+
+    Partial total = std::move(partials[0].value);
+    for (size_t i = 1; i < partials.size(); ++i) {
+        merge(total, partials[i].value);
+    }
+    return total;
+}
+
+#endif // PARALLEL_SCAN_H
@@ -0,0 +1,138 @@
+#include "persist.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+#include <cpuid.h>
+#include <immintrin.h>
+
+__attribute__((target("clwb")))
+static void flushLinesClwb(const char* line, const char* end) {
+    for (; line < end; line += CACHE_LINE_SIZE) {
+        _mm_clwb(const_cast<char*>(line));
+    }
+}
+
+__attribute__((target("clflushopt")))
+static void flushLinesClflushopt(const char* line, const char* end) {
+    for (; line < end; line += CACHE_LINE_SIZE) {
+        _mm_clflushopt(const_cast<char*>(line));
+    }
+}
+
+static void flushLinesClflush(const char* line, const char* end) {
+    for (; line < end; line += CACHE_LINE_SIZE) {
+        _mm_clflush(line);
+    }
+}
+#endif
+
+FlushMethod detectFlushMethod() {
+#if defined(__x86_64__)
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        if (ebx & (1u << 24)) {
+            return FlushMethod::Clwb;
+        }
+        if (ebx & (1u << 23)) {
+            return FlushMethod::Clflushopt;
+        }
+    }
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & (1u << 19))) {
+        return FlushMethod::Clflush;
+    }
+#endif
+    return FlushMethod::Msync;
+}
+
+const char* flushMethodName(FlushMethod method) {
+    switch (method) {
+        case FlushMethod::Clwb: return "clwb";
+        case FlushMethod::Clflushopt: return "clflushopt";
+        case FlushMethod::Clflush: return "clflush";
+        case FlushMethod::Msync: return "msync";
+    }
+    return "unknown";
+}
+
+void flushRange(const void* addr, size_t size, FlushMethod method) {
+    if (size == 0) {
+        return;
+    }
+    uintptr_t start = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t end = start + size;
+
+    if (method == FlushMethod::Msync) {
+        uintptr_t page_size = sysconf(_SC_PAGESIZE);
+        uintptr_t page_start = start & ~(page_size - 1);
+        if (msync(reinterpret_cast<void*>(page_start), end - page_start, MS_SYNC) == -1) {
+            perror("msync failed");
+            throw std::runtime_error("Failed to msync mapped range");
+        }
+        return;
+    }
+
+#if defined(__x86_64__)
+    const char* line = reinterpret_cast<const char*>(start & ~(CACHE_LINE_SIZE - 1));
+    const char* last = reinterpret_cast<const char*>(end);
+    switch (method) {
+        case FlushMethod::Clwb: flushLinesClwb(line, last); break;
+        case FlushMethod::Clflushopt: flushLinesClflushopt(line, last); break;
+        default: flushLinesClflush(line, last); break;
+    }
+#endif
+}
+
+void nonTemporalCopy(void* dst, const void* src, size_t size, FlushMethod method) {
+#if defined(__x86_64__)
+    if (method == FlushMethod::Msync) {
+        // msync writes back whole pages, streaming stores would not help
+        memcpy(dst, src, size);
+        flushRange(dst, size, method);
+        return;
+    }
+
+    char* out = static_cast<char*>(dst);
+    const char* in = static_cast<const char*>(src);
+
+    // Regular stores up to the first 16-byte boundary
+    size_t head = (16 - (reinterpret_cast<uintptr_t>(out) & 15)) & 15;
+    head = head < size ? head : size;
+    memcpy(out, in, head);
+    flushRange(out, head, method);
+    out += head;
+    in += head;
+    size -= head;
+
+    // Streaming stores for the aligned body
+    size_t body = size & ~static_cast<size_t>(15);
+    for (size_t i = 0; i < body; i += 16) {
+        __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm_stream_si128(reinterpret_cast<__m128i*>(out + i), chunk);
+    }
+    out += body;
+    in += body;
+    size -= body;
+
+    // Regular stores for the tail
+    memcpy(out, in, size);
+    flushRange(out, size, method);
+#else
+    memcpy(dst, src, size);
+    flushRange(dst, size, method);
+#endif
+}
+
+void persistFence() {
+#if defined(__x86_64__)
+    _mm_sfence();
+#else
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+}
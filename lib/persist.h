@@ -0,0 +1,42 @@
+#ifndef PERSIST_H
+#define PERSIST_H
+
+/*
+    * Persist helpers
+    * Copy and flush primitives for writers that store straight into a
+    * MAP_SHARED mapping of a DAX/CXL-backed file. The flush instruction is
+    * picked at runtime (clwb, clflushopt, clflush) and msync is used where no
+    * cache-line flush is available.
+*/
+
+#include <cstddef>
+
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+enum class FlushMethod {
+    Clwb,        // Write back, line may stay cached
+    Clflushopt,  // Weakly ordered flush + invalidate
+    Clflush,     // Strongly ordered flush + invalidate
+    Msync        // No user-space flush available
+};
+
+// Best flush instruction supported by this CPU
+FlushMethod detectFlushMethod();
+
+const char* flushMethodName(FlushMethod method);
+
+// Copy size bytes using non-temporal (streaming) stores where possible, so
+// the payload goes to memory without displacing the cache. The unaligned
+// head and tail are copied with regular stores and flushed with `method`.
+// With FlushMethod::Msync the copy is a plain memcpy followed by msync.
+// Call persistFence() before publishing the data.
+void nonTemporalCopy(void* dst, const void* src, size_t size, FlushMethod method);
+
+// Write back the cache lines covering [addr, addr + size). With
+// FlushMethod::Msync this calls msync on the enclosing pages instead.
+void flushRange(const void* addr, size_t size, FlushMethod method);
+
+// Order all earlier streaming stores and flushes before later stores
+void persistFence();
+
+#endif // PERSIST_H
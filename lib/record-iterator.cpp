@@ -0,0 +1,78 @@
+#include "record-iterator.h"
+
+#include <algorithm>
+
+#include "simd-search.h"
+
+RecordIterator::RecordIterator()
+    : reader_(nullptr), delimiter_('\n'), window_offset(0), position(0), record_offset(0) {}
+
+RecordIterator::RecordIterator(ZeroCopyRead& reader, char delimiter, size_t offset)
+    : reader_(&reader), delimiter_(delimiter), window_offset(offset), position(offset), record_offset(offset) {
+    advance();
+}
+
+void RecordIterator::advance() {
+    if (reader_ == nullptr) {
+        return;
+    }
+    size_t size = reader_->getFileSize();
+    if (position >= size) {
+        size = reader_->refresh();  // Follow mode may have more data
+        if (position >= size) {
+            reader_ = nullptr;
+            return;
+        }
+    }
+
+    size_t window_size = RECORD_WINDOW_SIZE;
+    while (true) {
+        size_t window_end = window_offset + window.size();
+        if (position < window_offset || position >= window_end) {
+            // One coordination check for the next window of records
+            window = reader_->view(position, std::min(window_size, size - position));
+            window_offset = position;
+            reader_->prefetchAhead(position);
+            window_end = window_offset + window.size();
+            if (window.empty()) {
+                reader_ = nullptr;
+                return;
+            }
+        }
+
+        const char* start = window.data() + (position - window_offset);
+        const char* end = window.data() + window.size();
+        const char* found = findByte(start, end, delimiter_);
+        if (found != end) {
+            record = std::string_view(start, found - start);
+            record_offset = position;
+            position += record.size() + 1;
+            return;
+        }
+        if (window_end >= size) {
+            if (reader_->isFollowing() && !reader_->isSealed()) {
+                // The writer may still be appending this record: take what
+                // arrived since, or stop before it so that a later pass
+                // starting at its offset yields it whole
+                size_t new_size = reader_->refresh();
+                if (new_size > size) {
+                    size = new_size;
+                    window = std::string_view();
+                    continue;
+                }
+                if (!reader_->isSealed()) {
+                    reader_ = nullptr;
+                    return;
+                }
+            }
+            // Last record, not terminated by a delimiter
+            record = std::string_view(start, end - start);
+            record_offset = position;
+            position = window_end;
+            return;
+        }
+        // The record runs past the window: map a larger one starting at it
+        window_size = std::max<size_t>(window_size, (end - start) * 2);
+        window = std::string_view();
+    }
+}
@@ -0,0 +1,90 @@
+#ifndef RECORD_ITERATOR_H
+#define RECORD_ITERATOR_H
+
+/*
+    * Record Iterator
+    * Iterates over the delimiter-separated records of a ZeroCopyRead file,
+    * yielding each record as a view into the mapping (delimiter excluded).
+    * Delimiters are found with the vectorized findByte(), and coordination
+    * with the writer is checked once per window of RECORD_WINDOW_SIZE bytes
+    * instead of once per byte.
+    *
+    *     for (std::string_view line : records(reader)) { ... }
+    *
+    * An unterminated last record is yielded once the file is complete: the
+    * reader does not follow it, or the writer sealed it. A follow-mode reader
+    * stops before it instead, since the writer may still be appending it;
+    * iterating again from the end of the last record yields it whole.
+*/
+
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+
+#include "zero-copy-read-library.h"
+
+static constexpr size_t RECORD_WINDOW_SIZE = 1 << 20;
+
+class RecordIterator {
+    private:
+        ZeroCopyRead* reader_;     // nullptr for the end iterator
+        char delimiter_;
+        std::string_view window;   // Validated view of the file at window_offset
+        size_t window_offset;
+        size_t position;           // Offset of the record after the current one
+        size_t record_offset;
+        std::string_view record;
+
+        // Find the record starting at position, or become the end iterator
+        void advance();
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        // End iterator
+        RecordIterator();
+        RecordIterator(ZeroCopyRead& reader, char delimiter, size_t offset);
+
+        reference operator*() const { return record; }
+        pointer operator->() const { return &record; }
+
+        RecordIterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        bool operator==(const RecordIterator& other) const {
+            return reader_ == other.reader_ && (reader_ == nullptr || record_offset == other.record_offset);
+        }
+        bool operator!=(const RecordIterator& other) const { return !(*this == other); }
+
+        // File offset of the current record
+        size_t offset() const { return record_offset; }
+};
+
+using LineIterator = RecordIterator;
+
+class RecordRange {
+    private:
+        ZeroCopyRead& reader_;
+        char delimiter_;
+        size_t offset_;
+
+    public:
+        RecordRange(ZeroCopyRead& reader, char delimiter, size_t offset)
+            : reader_(reader), delimiter_(delimiter), offset_(offset) {}
+
+        RecordIterator begin() const { return RecordIterator(reader_, delimiter_, offset_); }
+        RecordIterator end() const { return RecordIterator(); }
+};
+
+// Records of reader separated by delimiter, starting at offset
+inline RecordRange records(ZeroCopyRead& reader, char delimiter = '\n', size_t offset = 0) {
+    return RecordRange(reader, delimiter, offset);
+}
+
+#endif // RECORD_ITERATOR_H
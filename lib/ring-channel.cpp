@@ -0,0 +1,272 @@
+#include "ring-channel.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static constexpr size_t RING_RECORD_ALIGN = 8;
+
+static size_t recordSpan(size_t size) {
+    return (sizeof(RingRecordHeader) + size + RING_RECORD_ALIGN - 1) & ~(RING_RECORD_ALIGN - 1);
+}
+
+// Milliseconds left until deadline for a wait of timeout_ms; -1 forever
+static int remainingMs(int timeout_ms, std::chrono::steady_clock::time_point deadline) {
+    if (timeout_ms < 0) {
+        return -1;
+    }
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    return left > 0 ? static_cast<int>(left) : 0;
+}
+
+RingChannel::RingChannel(const char* path, const RingChannelOptions& options)
+    : header(nullptr), data(nullptr), capacity(0), mapped_size(0), options_(options) {
+    if (options_.capacity < RING_HEADER_SIZE || options_.capacity > RING_MAX_CAPACITY
+        || (options_.capacity & (options_.capacity - 1)) != 0) {
+        throw std::invalid_argument("Ring capacity must be a power of two from 4096 to 2 GiB");
+    }
+    fd = open(path, O_RDWR | O_CREAT, 0666);
+    if (fd == -1) {
+        perror("Failed to open ring file");
+        throw std::runtime_error("Failed to open ring file");
+    }
+    waiter_.watchLockFile(fd);
+
+    // One process initializes the ring; the others wait for it here
+    flock(fd, LOCK_EX);
+    try {
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == -1) {
+            perror("fstat failed");
+            throw std::runtime_error("Failed to get ring file size");
+        }
+        size_t file_size = file_stat.st_size;
+        std::uint64_t existing[2] = { 0, 0 };  // RingHeader::magic and capacity
+        std::uint64_t magic = 0;
+        std::uint64_t ring_capacity = options_.capacity;
+        if (file_size >= RING_HEADER_SIZE
+            && pread(fd, existing, sizeof(existing), 0) == static_cast<ssize_t>(sizeof(existing))
+            && existing[0] == RING_MAGIC) {
+            magic = existing[0];
+            ring_capacity = existing[1];
+            if (ring_capacity < RING_HEADER_SIZE || ring_capacity > RING_MAX_CAPACITY
+                || (ring_capacity & (ring_capacity - 1)) != 0
+                || file_size < RING_HEADER_SIZE + ring_capacity) {
+                throw std::runtime_error("Corrupt ring header");
+            }
+        } else if (file_size < RING_HEADER_SIZE + ring_capacity) {
+            // famfs files cannot grow: they have to be created large enough
+            if (ftruncate(fd, RING_HEADER_SIZE + ring_capacity) == -1) {
+                perror("ftruncate failed");
+                throw std::runtime_error("Ring file is too small for the capacity");
+            }
+        }
+        capacity = ring_capacity;
+        mapped_size = RING_HEADER_SIZE + capacity;
+        void* map = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            perror("mmap failed");
+            throw std::runtime_error("Failed to mmap ring file");
+        }
+        header = static_cast<RingHeader*>(map);
+        data = static_cast<char*>(map) + RING_HEADER_SIZE;
+
+        if (magic != RING_MAGIC) {
+            // A preallocated file may hold anything: a zero record header is
+            // what marks free space
+            memset(map, 0, mapped_size);
+            header->capacity.store(capacity, std::memory_order_relaxed);
+            header->flags.store(options_.multi_producer ? RING_MULTI_PRODUCER : 0, std::memory_order_relaxed);
+            header->magic.store(RING_MAGIC, std::memory_order_release);
+        }
+    } catch (...) {
+        if (header != nullptr) {
+            munmap(header, mapped_size);
+        }
+        flock(fd, LOCK_UN);
+        ::close(fd);
+        throw;
+    }
+    flock(fd, LOCK_UN);
+}
+
+RingChannel::~RingChannel() {
+    munmap(header, mapped_size);
+    ::close(fd);
+}
+
+void RingChannel::signal(ControlBlock* ready) {
+    // Bumped before sleepers is read, as in endControlBlockWrite
+    ready->wake_word.fetch_add(1, std::memory_order_seq_cst);
+    if (ready->sleepers.load(std::memory_order_seq_cst) != 0) {
+        wakeControlBlockSleepers(ready, fd);
+    }
+}
+
+bool RingChannel::waitFor(ControlBlock* ready, std::uint32_t seen, int timeout_ms) {
+    if (options_.wait == RingWait::Block) {
+        return waiter_.waitForCommit(ready, seen, timeout_ms);
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (ready->wake_word.load(std::memory_order_acquire) == seen) {
+        if (timeout_ms >= 0 && std::chrono::steady_clock::now() >= deadline) {
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    return true;
+}
+
+RingProducer::RingProducer(const char* path, const RingChannelOptions& options)
+    : RingChannel(path, options), cached_head(0) {}
+
+RingReservation RingProducer::reserve(size_t size, int timeout_ms) {
+    if (size > maxMessageSize()) {
+        throw std::invalid_argument("Message is larger than the ring allows");
+    }
+    size_t span = recordSpan(size);
+    bool multi_producer = header->flags.load(std::memory_order_relaxed) & RING_MULTI_PRODUCER;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (true) {
+        // Taken before the space check: a release after it wakes the wait below
+        std::uint32_t seen = header->space_ready.wake_word.load(std::memory_order_seq_cst);
+        std::uint64_t tail = header->tail.load(std::memory_order_relaxed);
+        while (true) {
+            size_t to_end = capacity - (tail & (capacity - 1));
+            size_t padding = to_end < span ? to_end : 0;
+            std::uint64_t end = tail + padding + span;
+            if (end - cached_head > capacity) {
+                cached_head = header->head.load(std::memory_order_acquire);
+                if (cached_head > tail) {
+                    // Other producers moved the tail and the consumer followed
+                    tail = header->tail.load(std::memory_order_relaxed);
+                    continue;
+                }
+                if (end - cached_head > capacity) {
+                    break;  // Full
+                }
+            }
+            if (multi_producer) {
+                if (!header->tail.compare_exchange_weak(tail, end, std::memory_order_relaxed)) {
+                    continue;  // Another producer claimed it: tail was reloaded
+                }
+            } else {
+                header->tail.store(end, std::memory_order_relaxed);
+            }
+            if (padding != 0) {
+                RingRecordHeader* pad = recordAt(tail);
+                pad->span = static_cast<std::uint32_t>(padding);
+                pad->state.store(RING_RECORD_COMMITTED | RING_RECORD_PADDING, std::memory_order_release);
+            }
+            RingReservation reservation;
+            reservation.record = recordAt(tail + padding);
+            reservation.record->span = static_cast<std::uint32_t>(span);
+            reservation.data = reinterpret_cast<char*>(reservation.record + 1);
+            reservation.size = size;
+            return reservation;
+        }
+        int remaining = remainingMs(timeout_ms, deadline);
+        if (remaining == 0) {
+            return RingReservation();  // Still full
+        }
+        waitFor(&header->space_ready, seen, remaining);
+    }
+}
+
+void RingProducer::commit(const RingReservation& reservation) {
+    commit(reservation, reservation.size);
+}
+
+void RingProducer::commit(const RingReservation& reservation, size_t used) {
+    if (used > reservation.size) {
+        throw std::invalid_argument("Committed more than was reserved");
+    }
+    reservation.record->state.store(RING_RECORD_COMMITTED | static_cast<std::uint32_t>(used),
+                                    std::memory_order_release);
+    signal(&header->data_ready);
+}
+
+bool RingProducer::send(const void* message, size_t size, int timeout_ms) {
+    RingReservation reservation = reserve(size, timeout_ms);
+    if (!reservation) {
+        return false;
+    }
+    memcpy(reservation.data, message, size);
+    commit(reservation);
+    return true;
+}
+
+void RingProducer::close() {
+    header->flags.fetch_or(RING_CLOSED, std::memory_order_release);
+    signal(&header->data_ready);
+}
+
+RingConsumer::RingConsumer(const char* path, const RingChannelOptions& options)
+    : RingChannel(path, options), current(nullptr) {
+    position = header->head.load(std::memory_order_acquire);  // Resume where the last consumer stopped
+}
+
+RingRecordHeader* RingConsumer::next() {
+    while (true) {
+        RingRecordHeader* record = recordAt(position);
+        std::uint32_t state = record->state.load(std::memory_order_acquire);
+        if (state == 0) {
+            return nullptr;  // Not committed yet
+        }
+        if (!(state & RING_RECORD_PADDING)) {
+            return record;
+        }
+        advance(record);
+    }
+}
+
+void RingConsumer::advance(RingRecordHeader* record) {
+    size_t span = record->span;
+    memset(static_cast<void*>(record), 0, span);
+    position += span;
+    header->head.store(position, std::memory_order_release);
+    signal(&header->space_ready);
+}
+
+bool RingConsumer::peek(std::string_view* message, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (current == nullptr) {
+        // Taken before looking: a commit after it wakes the wait below
+        std::uint32_t seen = header->data_ready.wake_word.load(std::memory_order_seq_cst);
+        current = next();
+        if (current != nullptr) {
+            break;
+        }
+        if (isClosed()) {
+            // Records committed before close() are visible by now
+            current = next();
+            if (current == nullptr) {
+                return false;
+            }
+            break;
+        }
+        int remaining = remainingMs(timeout_ms, deadline);
+        if (remaining == 0) {
+            return false;
+        }
+        waitFor(&header->data_ready, seen, remaining);
+    }
+    std::uint32_t state = current->state.load(std::memory_order_relaxed);
+    *message = std::string_view(reinterpret_cast<const char*>(current + 1), state & RING_RECORD_LENGTH_MASK);
+    return true;
+}
+
+void RingConsumer::release() {
+    if (current != nullptr) {
+        advance(current);
+        current = nullptr;
+    }
+}
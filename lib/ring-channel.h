@@ -0,0 +1,193 @@
+#ifndef RING_CHANNEL_H
+#define RING_CHANNEL_H
+
+/*
+    * Ring Channel
+    * A fixed-capacity message channel in one preallocated file (famfs or
+    * tmpfs), for streams of short messages that should not grow a file.
+    * Producers reserve room for a record, write the message in place and
+    * commit it; the consumer peeks at the next committed record in place and
+    * releases it. A record never wraps: one that does not fit before the end
+    * of the data area is preceded by a padding record.
+    *
+    *     RingProducer producer("/mnt/famfs-mount/ring");
+    *     RingReservation slot = producer.reserve(msg.size());
+    *     memcpy(slot.data, msg.data(), msg.size());
+    *     producer.commit(slot);
+    *
+    *     RingConsumer consumer("/mnt/famfs-mount/ring");
+    *     std::string_view message;
+    *     while (consumer.peek(&message, -1)) {
+    *         handle(message);
+    *         consumer.release();
+    *     }
+    *
+    * The file starts with a 4 KiB header page: the configuration, the
+    * producers' tail and the consumer's head on cache lines of their own,
+    * and two ControlBlocks used only for their wake words (data committed,
+    * space released). The data area follows. Cursors only grow; positions
+    * are taken modulo the capacity, a power of two.
+    *
+    * A record is committed by a release store of its length into its
+    * header. The consumer zeroes what it releases, so a zero header means
+    * "not committed yet" whatever the ring held before. With several
+    * producers the tail is claimed with a CAS, and records are consumed in
+    * the order they were reserved.
+    *
+    * When the ring is full reserve() waits for space (backpressure); when it
+    * is empty peek() waits for a commit. Waits spin, then sleep on the wake
+    * word (ControlBlockWaiter), or only poll with RingWait::Poll. While the
+    * other side keeps up, neither makes a syscall.
+*/
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "control-block.h"
+
+static constexpr std::uint64_t RING_MAGIC = 0x3130474e5252435aULL; // "ZCRRNG01"
+static constexpr size_t RING_HEADER_SIZE = 4096;                  // The data area starts here
+// Largest capacity: a record spans at most half of it, and its length has
+// to fit in RING_RECORD_LENGTH_MASK and its span in 32 bits
+static constexpr std::uint64_t RING_MAX_CAPACITY = 1ULL << 31;
+
+// RingHeader::flags bits
+static constexpr std::uint32_t RING_MULTI_PRODUCER = 1;  // Producers claim the tail with a CAS
+static constexpr std::uint32_t RING_CLOSED = 2;          // No more records will be committed
+
+// RingRecordHeader::state bits
+static constexpr std::uint32_t RING_RECORD_COMMITTED = 1U << 31;
+static constexpr std::uint32_t RING_RECORD_PADDING = 1U << 30;
+static constexpr std::uint32_t RING_RECORD_LENGTH_MASK = RING_RECORD_PADDING - 1;
+
+struct alignas(64) RingHeader {
+    std::atomic<std::uint64_t> magic;
+    std::atomic<std::uint64_t> capacity;            // Bytes of the data area, a power of two
+    std::atomic<std::uint32_t> flags;               // RING_MULTI_PRODUCER, RING_CLOSED
+    alignas(64) std::atomic<std::uint64_t> tail;    // Next byte producers reserve
+    alignas(64) std::atomic<std::uint64_t> head;    // Next byte the consumer releases
+    ControlBlock data_ready;                        // Wake word bumped on every commit
+    ControlBlock space_ready;                       // Wake word bumped on every release
+};
+
+static_assert(sizeof(RingHeader) <= RING_HEADER_SIZE, "RingHeader must fit in the header page");
+
+// Header of every record in the data area, 8-byte aligned
+struct RingRecordHeader {
+    std::atomic<std::uint32_t> state;   // 0 until committed, then COMMITTED | length (| PADDING)
+    std::uint32_t span;                 // Bytes from this header to the next one
+};
+
+// How a side waits for the other
+enum class RingWait {
+    Block,  // Spin briefly, then sleep on the wake word
+    Poll    // Spin and yield only; never sleeps in the kernel
+};
+
+struct RingChannelOptions {
+    // Bytes of the data area, a power of two from 4096 to RING_MAX_CAPACITY.
+    // Used when the ring is created; opening an existing ring takes its
+    // capacity from the header.
+    size_t capacity = 1 << 20;
+    // Several producers may reserve concurrently (CAS on the tail). Also only
+    // used at creation.
+    bool multi_producer = true;
+    RingWait wait = RingWait::Block;
+};
+
+// Room reserved by RingProducer::reserve: write up to size bytes at data,
+// then commit it
+struct RingReservation {
+    char* data = nullptr;               // nullptr when nothing was reserved
+    size_t size = 0;
+    RingRecordHeader* record = nullptr;
+
+    explicit operator bool() const { return data != nullptr; }
+};
+
+// Maps the ring file, creating and initializing the ring if the file does
+// not hold one yet
+class RingChannel {
+    protected:
+        int fd;
+        RingHeader* header;
+        char* data;                     // The data area, RING_HEADER_SIZE into the file
+        size_t capacity;
+        size_t mapped_size;
+        RingChannelOptions options_;
+        ControlBlockWaiter waiter_;
+
+        RingRecordHeader* recordAt(std::uint64_t position) const {
+            return reinterpret_cast<RingRecordHeader*>(data + (position & (capacity - 1)));
+        }
+        // Bump the wake word, waking the other side if it sleeps on it
+        void signal(ControlBlock* ready);
+        // Wait until the wake word moves past seen, up to timeout_ms
+        // (negative waits forever). Returns false on timeout.
+        bool waitFor(ControlBlock* ready, std::uint32_t seen, int timeout_ms);
+
+    public:
+        RingChannel(const char* path, const RingChannelOptions& options);
+        ~RingChannel();
+
+        RingChannel(const RingChannel&) = delete;
+        RingChannel& operator=(const RingChannel&) = delete;
+
+        size_t getCapacity() const { return capacity; }
+        // Largest message a record can hold: half the capacity, so a record
+        // and the padding before it always fit in an empty ring
+        size_t maxMessageSize() const { return capacity / 2 - sizeof(RingRecordHeader); }
+        // Bytes reserved and not yet released
+        size_t used() const {
+            return header->tail.load(std::memory_order_acquire) - header->head.load(std::memory_order_acquire);
+        }
+        bool isClosed() const { return header->flags.load(std::memory_order_acquire) & RING_CLOSED; }
+};
+
+class RingProducer : public RingChannel {
+    private:
+        std::uint64_t cached_head;      // Last head read: the consumer's line is only read when the ring looks full
+
+    public:
+        explicit RingProducer(const char* path, const RingChannelOptions& options = RingChannelOptions());
+
+        // Reserve room for size bytes, waiting up to timeout_ms for the
+        // consumer to free space (negative waits forever, 0 fails at once when
+        // full). Throws std::invalid_argument above maxMessageSize().
+        RingReservation reserve(size_t size, int timeout_ms = -1);
+        // Publish a reserved record; used may be less than the reserved size
+        void commit(const RingReservation& reservation);
+        void commit(const RingReservation& reservation, size_t used);
+
+        // reserve, copy and commit. Returns false on timeout.
+        bool send(const void* message, size_t size, int timeout_ms = -1);
+
+        // No more records: the consumer sees the ring closed once it drained it
+        void close();
+};
+
+class RingConsumer : public RingChannel {
+    private:
+        std::uint64_t position;         // Start of the next record to read
+        RingRecordHeader* current;      // Record returned by peek, until released
+
+        // The committed record at position, skipping padding; nullptr if none
+        RingRecordHeader* next();
+        // Zero the record at position and hand its space back to the producers
+        void advance(RingRecordHeader* record);
+
+    public:
+        explicit RingConsumer(const char* path, const RingChannelOptions& options = RingChannelOptions());
+
+        // View the next message in place, waiting up to timeout_ms for one
+        // (negative waits forever, 0 only looks). Returns false on timeout, or
+        // when the ring is closed and drained. Peeking again before release()
+        // returns the same message.
+        bool peek(std::string_view* message, int timeout_ms = 0);
+        // Release the message returned by peek; the view becomes invalid
+        void release();
+};
+
+#endif // RING_CHANNEL_H
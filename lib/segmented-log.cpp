@@ -0,0 +1,318 @@
+#include "segmented-log.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string manifestPath(const std::string& log_dir) {
+    return log_dir + "/manifest";
+}
+
+std::string segmentPath(const std::string& log_dir, size_t index) {
+    char name[32];
+    snprintf(name, sizeof(name), "/segment-%08zu", index);
+    return log_dir + name;
+}
+
+// Readers map whole segments back to back, so a segment is whole pages
+static bool validSegmentSize(std::uint64_t segment_size) {
+    return segment_size != 0 && segment_size % sysconf(_SC_PAGESIZE) == 0;
+}
+
+SegmentedLogWriter::SegmentedLogWriter(const char* log_dir, const SegmentedLogOptions& options)
+    : log_dir_(log_dir), options_(options), segment_fd(-1), segment_index(0), committed_length(0) {
+    if (!validSegmentSize(options_.segment_size)) {
+        throw std::invalid_argument("Segment size must be a multiple of the page size");
+    }
+    if (mkdir(log_dir_.c_str(), 0777) == -1 && errno != EEXIST) {
+        perror("Failed to create log directory");
+        throw std::runtime_error("Failed to create log directory");
+    }
+
+    manifest_fd = open(manifestPath(log_dir_).c_str(), O_RDWR | O_CREAT, 0666);
+    if (manifest_fd < 0) {
+        perror("Failed to open manifest");
+        throw std::runtime_error("Failed to open manifest");
+    }
+    struct stat manifest_stat;
+    if (fstat(manifest_fd, &manifest_stat) == -1) {
+        perror("Failed to get manifest size");
+        close(manifest_fd);
+        throw std::runtime_error("Failed to get manifest size");
+    }
+    if (static_cast<size_t>(manifest_stat.st_size) < sizeof(SegmentManifest)
+        && ftruncate(manifest_fd, sizeof(SegmentManifest)) == -1) {
+        perror("Failed to grow manifest");
+        close(manifest_fd);
+        throw std::runtime_error("Failed to grow manifest");
+    }
+    void* ptr = mmap(nullptr, sizeof(SegmentManifest), PROT_READ | PROT_WRITE, MAP_SHARED, manifest_fd, 0);
+    if (ptr == MAP_FAILED) {
+        perror("Failed to mmap manifest");
+        close(manifest_fd);
+        throw std::runtime_error("Failed to mmap manifest");
+    }
+    manifest = static_cast<SegmentManifest*>(ptr);
+
+    if (manifest->magic.load(std::memory_order_acquire) == SEGMENT_MANIFEST_MAGIC) {
+        // Resume an existing log; its segment size wins over the options
+        options_.segment_size = manifest->segment_size.load(std::memory_order_relaxed);
+        if (!validSegmentSize(options_.segment_size)) {
+            munmap(manifest, sizeof(SegmentManifest));
+            close(manifest_fd);
+            throw std::runtime_error("Segment size must be a multiple of the page size");
+        }
+        committed_length = manifest->committed_length.load(std::memory_order_relaxed);
+        manifest->sequence.fetch_and(~1ULL, std::memory_order_release);
+    } else {
+        manifest->sequence.store(0, std::memory_order_relaxed);
+        manifest->segment_size.store(options_.segment_size, std::memory_order_relaxed);
+        manifest->segment_count.store(0, std::memory_order_relaxed);
+        manifest->committed_length.store(0, std::memory_order_relaxed);
+        manifest->magic.store(SEGMENT_MANIFEST_MAGIC, std::memory_order_release);
+    }
+
+    openSegment(committed_length / options_.segment_size);
+    preallocate();
+}
+
+SegmentedLogWriter::~SegmentedLogWriter() {
+    if (segment_fd >= 0) {
+        close(segment_fd);
+    }
+    munmap(manifest, sizeof(SegmentManifest));
+    close(manifest_fd);
+}
+
+void SegmentedLogWriter::createSegment(size_t index) {
+    std::string path = segmentPath(log_dir_, index);
+    if (options_.backend == SegmentBackend::Famfs) {
+        std::string cmd = "sudo famfs creat -s " + std::to_string(options_.segment_size) + " " + path;
+        int ret = std::system(cmd.c_str());
+        if (ret != 0) {
+            throw std::runtime_error("Failed to execute system command: " + cmd);
+        }
+    } else {
+        int new_fd = open(path.c_str(), O_RDWR | O_CREAT, 0666);
+        if (new_fd < 0) {
+            perror("Failed to create segment");
+            throw std::runtime_error("Failed to create segment " + path);
+        }
+        // Reserve the blocks now so appends never allocate; fall back to a
+        // sparse file where fallocate is not supported
+        int err = posix_fallocate(new_fd, 0, options_.segment_size);
+        if (err != 0 && ftruncate(new_fd, options_.segment_size) == -1) {
+            perror("Failed to size segment");
+            close(new_fd);
+            throw std::runtime_error("Failed to size segment " + path);
+        }
+        close(new_fd);
+    }
+    // Segments are only ever added at the end
+    manifest->segment_count.store(index + 1, std::memory_order_release);
+}
+
+void SegmentedLogWriter::openSegment(size_t index) {
+    while (manifest->segment_count.load(std::memory_order_relaxed) <= index) {
+        createSegment(manifest->segment_count.load(std::memory_order_relaxed));
+    }
+    int new_fd = open(segmentPath(log_dir_, index).c_str(), O_WRONLY);
+    if (new_fd < 0) {
+        perror("Failed to open segment");
+        throw std::runtime_error("Failed to open segment");
+    }
+    if (segment_fd >= 0) {
+        close(segment_fd);
+    }
+    segment_fd = new_fd;
+    segment_index = index;
+}
+
+void SegmentedLogWriter::preallocate() {
+    size_t wanted = segment_index + 1 + options_.preallocate_segments;
+    while (manifest->segment_count.load(std::memory_order_relaxed) < wanted) {
+        createSegment(manifest->segment_count.load(std::memory_order_relaxed));
+    }
+}
+
+void SegmentedLogWriter::writeData(const char* data, size_t size) {
+    std::uint64_t seq = manifest->sequence.load(std::memory_order_relaxed);
+    manifest->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    while (size > 0) {
+        size_t index = committed_length / options_.segment_size;
+        size_t offset = committed_length % options_.segment_size;
+        if (index != segment_index) {
+            openSegment(index);
+        }
+        size_t chunk = std::min<size_t>(size, options_.segment_size - offset);
+        ssize_t bytes_written = pwrite(segment_fd, data, chunk, offset);
+        if (bytes_written < 0) {
+            perror("Failed to write data");
+            manifest->committed_length.store(committed_length, std::memory_order_relaxed);
+            manifest->sequence.store(seq + 2, std::memory_order_release);
+            throw std::runtime_error("Failed to write data");
+        }
+        committed_length += bytes_written;
+        data += bytes_written;
+        size -= bytes_written;
+    }
+
+    manifest->committed_length.store(committed_length, std::memory_order_relaxed);
+    manifest->sequence.store(seq + 2, std::memory_order_release);
+
+    // Keep segments ready ahead of the cursor, outside the locked window
+    preallocate();
+}
+
+size_t SegmentedLogWriter::getCommittedLength() const {
+    return committed_length;
+}
+
+SegmentedLogReader::SegmentedLogReader(const char* log_dir, size_t reserve_size)
+    : log_dir_(log_dir), segments_mapped(0), committed_length(0) {
+    manifest_fd = open(manifestPath(log_dir_).c_str(), O_RDONLY);
+    if (manifest_fd < 0) {
+        perror("Failed to open manifest");
+        throw std::runtime_error("Failed to open manifest");
+    }
+    struct stat manifest_stat;
+    if (fstat(manifest_fd, &manifest_stat) == -1
+        || static_cast<size_t>(manifest_stat.st_size) < sizeof(SegmentManifest)) {
+        close(manifest_fd);
+        throw std::runtime_error("Manifest is missing or truncated");
+    }
+    void* ptr = mmap(nullptr, sizeof(SegmentManifest), PROT_READ, MAP_SHARED, manifest_fd, 0);
+    if (ptr == MAP_FAILED) {
+        perror("Failed to mmap manifest");
+        close(manifest_fd);
+        throw std::runtime_error("Failed to mmap manifest");
+    }
+    manifest = static_cast<const SegmentManifest*>(ptr);
+    if (manifest->magic.load(std::memory_order_acquire) != SEGMENT_MANIFEST_MAGIC) {
+        munmap(ptr, sizeof(SegmentManifest));
+        close(manifest_fd);
+        throw std::runtime_error("Manifest is not initialized");
+    }
+
+    segment_size = manifest->segment_size.load(std::memory_order_relaxed);
+    if (!validSegmentSize(segment_size)) {
+        munmap(ptr, sizeof(SegmentManifest));
+        close(manifest_fd);
+        throw std::runtime_error("Segment size must be a multiple of the page size");
+    }
+
+    reserved_size = std::max<size_t>(segment_size, reserve_size / segment_size * segment_size);
+    base_mmap_ptr = mmap(nullptr, reserved_size, PROT_NONE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base_mmap_ptr == MAP_FAILED) {
+        perror("mmap failed");
+        munmap(ptr, sizeof(SegmentManifest));
+        close(manifest_fd);
+        throw std::runtime_error("Failed to reserve address space");
+    }
+    refresh();
+}
+
+SegmentedLogReader::~SegmentedLogReader() {
+    munmap(base_mmap_ptr, reserved_size);
+    munmap(const_cast<SegmentManifest*>(manifest), sizeof(SegmentManifest));
+    close(manifest_fd);
+}
+
+void SegmentedLogReader::growReservation(size_t needed) {
+    size_t new_reserved = std::max(needed, reserved_size * 2);
+    char* new_base = static_cast<char*>(mmap(nullptr, new_reserved, PROT_NONE,
+                                             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+    if (new_base == MAP_FAILED) {
+        perror("mmap failed");
+        throw std::runtime_error("Failed to grow address space reservation");
+    }
+    // Each segment is its own mapping; move them one by one, keeping their
+    // page tables
+    char* old_base = static_cast<char*>(base_mmap_ptr);
+    for (size_t i = 0; i < segments_mapped; ++i) {
+        if (mremap(old_base + i * segment_size, segment_size, segment_size,
+                   MREMAP_MAYMOVE | MREMAP_FIXED, new_base + i * segment_size) == MAP_FAILED) {
+            perror("mremap failed");
+            // Put the segments already moved back where the old reservation
+            // has their slots, so base_mmap_ptr stays valid
+            for (size_t j = 0; j < i; ++j) {
+                mremap(new_base + j * segment_size, segment_size, segment_size,
+                       MREMAP_MAYMOVE | MREMAP_FIXED, old_base + j * segment_size);
+            }
+            munmap(new_base, new_reserved);
+            throw std::runtime_error("Failed to move segment mapping");
+        }
+    }
+    size_t used = segments_mapped * segment_size;
+    if (reserved_size > used) {
+        munmap(old_base + used, reserved_size - used);
+    }
+    base_mmap_ptr = new_base;
+    reserved_size = new_reserved;
+}
+
+void SegmentedLogReader::mapSegment(size_t index) {
+    size_t end = (index + 1) * segment_size;
+    if (end > reserved_size) {
+        growReservation(end);
+    }
+    int segment_fd = open(segmentPath(log_dir_, index).c_str(), O_RDONLY);
+    if (segment_fd < 0) {
+        perror("Failed to open segment");
+        throw std::runtime_error("Failed to open segment");
+    }
+    void* ptr = mmap(static_cast<char*>(base_mmap_ptr) + index * segment_size, segment_size,
+                     PROT_READ, MAP_SHARED | MAP_FIXED, segment_fd, 0);
+    close(segment_fd); // The mapping keeps the file alive
+    if (ptr == MAP_FAILED) {
+        perror("mmap failed");
+        throw std::runtime_error("Failed to mmap segment");
+    }
+    segments_mapped++;
+}
+
+size_t SegmentedLogReader::refresh() {
+    std::uint64_t length;
+    while (true) {
+        std::uint64_t begin = manifest->sequence.load(std::memory_order_acquire);
+        if (begin & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        length = manifest->committed_length.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (manifest->sequence.load(std::memory_order_relaxed) == begin) {
+            break;
+        }
+    }
+
+    size_t needed = (length + segment_size - 1) / segment_size;
+    while (segments_mapped < needed) {
+        mapSegment(segments_mapped);
+    }
+    committed_length = length;
+    return committed_length;
+}
+
+std::string_view SegmentedLogReader::view(size_t offset, size_t size) {
+    if (offset > committed_length || size > committed_length - offset) {
+        refresh();
+        if (offset > committed_length || size > committed_length - offset) {
+            return std::string_view(); // Not committed yet
+        }
+    }
+    return std::string_view(static_cast<const char*>(base_mmap_ptr) + offset, size);
+}
+
+size_t SegmentedLogReader::getCommittedLength() const {
+    return committed_length;
+}
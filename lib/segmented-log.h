@@ -0,0 +1,108 @@
+#ifndef SEGMENTED_LOG_H
+#define SEGMENTED_LOG_H
+
+/*
+    * Segmented Log
+    * An append-only log stored as a manifest plus a sequence of fixed-size
+    * segment files (BLOCK_SIZE each) in one directory. Growing the log only
+    * creates the next segment instead of copying the whole file, so the cost
+    * of an append does not depend on how large the log already is.
+    *
+    * The reader maps every segment back to back into one reserved address
+    * range, so the log appears as a single contiguous logical file.
+*/
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <sys/types.h>
+
+#include "write-library.h"
+
+static constexpr std::uint64_t SEGMENT_MANIFEST_MAGIC = 0x31304e474553435aULL; // "ZCSEGN01"
+
+// Manifest stored in <log_dir>/manifest and mapped by writer and readers
+struct alignas(64) SegmentManifest {
+    std::atomic<std::uint64_t> magic;
+    std::atomic<std::uint64_t> sequence;         // Seqlock counter, odd while appending
+    std::atomic<std::uint64_t> segment_size;     // Bytes per segment file
+    std::atomic<std::uint64_t> segment_count;    // Segment files created, including preallocated ones
+    std::atomic<std::uint64_t> committed_length; // Logical bytes readers may use
+};
+
+// Where segment files are created
+enum class SegmentBackend {
+    Local, // Regular files on any local filesystem (tmpfs, ext4, ...)
+    Famfs  // famfs files created with `famfs creat -s`
+};
+
+struct SegmentedLogOptions {
+    SegmentBackend backend = SegmentBackend::Local;
+    std::uint64_t segment_size = BLOCK_SIZE;  // A multiple of the page size
+    // Segments kept allocated ahead of the write cursor
+    size_t preallocate_segments = 2;
+};
+
+class SegmentedLogWriter {
+    private:
+        std::string log_dir_;
+        SegmentedLogOptions options_;
+        int manifest_fd;
+        SegmentManifest* manifest;
+        int segment_fd;                // Segment currently being appended to
+        size_t segment_index;          // Index of the segment behind segment_fd
+        size_t committed_length;
+
+        void createSegment(size_t index);
+        void openSegment(size_t index);
+        // Create segments until `preallocate_segments` are ready past the cursor
+        void preallocate();
+
+    public:
+        // Opens the log in log_dir, creating it if needed. An existing log is
+        // resumed at its committed length.
+        SegmentedLogWriter(const char* log_dir, const SegmentedLogOptions& options = SegmentedLogOptions());
+        ~SegmentedLogWriter();
+
+        // Append data to the log and publish the new committed length
+        void writeData(const char* data, size_t size);
+
+        size_t getCommittedLength() const;
+};
+
+class SegmentedLogReader {
+    private:
+        std::string log_dir_;
+        int manifest_fd;
+        const SegmentManifest* manifest;
+        std::uint64_t segment_size;
+        size_t segments_mapped;
+        size_t committed_length;
+        void* base_mmap_ptr;
+        size_t reserved_size;
+
+        void mapSegment(size_t index);
+        void growReservation(size_t needed);
+
+    public:
+        // reserve_size is the address space reserved for the whole log; it is
+        // grown with mremap if the log outgrows it.
+        explicit SegmentedLogReader(const char* log_dir, size_t reserve_size = 1ULL << 36);
+        ~SegmentedLogReader();
+
+        // Map segments appended since the last call. Returns the committed length.
+        size_t refresh();
+
+        // View of [offset, offset + size) in the logical log, possibly spanning
+        // several segments. Empty if the range is not committed yet. Valid
+        // until the reader is destroyed or its reservation has to grow.
+        std::string_view view(size_t offset, size_t size);
+
+        size_t getCommittedLength() const;
+};
+
+// Path of segment `index` inside log_dir
+std::string segmentPath(const std::string& log_dir, size_t index);
+
+#endif // SEGMENTED_LOG_H
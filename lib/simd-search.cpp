@@ -0,0 +1,91 @@
+#include "simd-search.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+
+__attribute__((target("avx2")))
+static const char* findByteAvx2(const char* p, const char* end, char byte) {
+    const __m256i needle = _mm256_set1_epi8(byte);
+    // Two vectors per iteration keep both load ports busy
+    for (; end - p >= 64; p += 64) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 32));
+        std::uint32_t mask_a = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, needle));
+        std::uint32_t mask_b = _mm256_movemask_epi8(_mm256_cmpeq_epi8(b, needle));
+        if (mask_a | mask_b) {
+            return mask_a ? p + __builtin_ctz(mask_a) : p + 32 + __builtin_ctz(mask_b);
+        }
+    }
+    for (; end - p >= 32; p += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        std::uint32_t mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(a, needle));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    for (; p < end; ++p) {
+        if (*p == byte) {
+            return p;
+        }
+    }
+    return end;
+}
+
+static const char* findByteSse2(const char* p, const char* end, char byte) {
+    const __m128i needle = _mm_set1_epi8(byte);
+    for (; end - p >= 16; p += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        unsigned int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(a, needle));
+        if (mask) {
+            return p + __builtin_ctz(mask);
+        }
+    }
+    for (; p < end; ++p) {
+        if (*p == byte) {
+            return p;
+        }
+    }
+    return end;
+}
+#else
+static const char* findByteMemchr(const char* p, const char* end, char byte) {
+    const void* found = memchr(p, byte, end - p);
+    return found ? static_cast<const char*>(found) : end;
+}
+#endif
+
+using FindByteFn = const char* (*)(const char*, const char*, char);
+
+struct FindByteDispatch {
+    FindByteFn fn;
+    const char* name;
+};
+
+static FindByteDispatch selectFindByte() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { findByteAvx2, "avx2" };
+    }
+    return { findByteSse2, "sse2" };
+#else
+    return { findByteMemchr, "memchr" };
+#endif
+}
+
+// Resolved on first use, so callers from other static initializers are safe
+static const FindByteDispatch& findByteDispatch() {
+    static const FindByteDispatch dispatch = selectFindByte();
+    return dispatch;
+}
+
+const char* findByte(const char* begin, const char* end, char byte) {
+    return findByteDispatch().fn(begin, end, byte);
+}
+
+const char* findByteImplementation() {
+    return findByteDispatch().name;
+}
@@ -0,0 +1,19 @@
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+/*
+    * SIMD byte search
+    * Vectorized delimiter search used by the record iterators and the line
+    * index. The implementation (AVX2 or SSE2 on x86-64, memchr elsewhere) is
+    * chosen once at runtime from the CPU features.
+*/
+
+#include <cstddef>
+
+// First occurrence of byte in [begin, end), or end if there is none
+const char* findByte(const char* begin, const char* end, char byte);
+
+// Name of the implementation selected for this CPU ("avx2", "sse2", "memchr")
+const char* findByteImplementation();
+
+#endif // SIMD_SEARCH_H
@@ -0,0 +1,66 @@
+#include "stats.h"
+
+#include <sstream>
+#include <sys/resource.h>
+
+WriterStats WriterCounters::snapshot() const {
+    WriterStats stats;
+    stats.write_calls = write_calls.load();
+    stats.batch_writes = batch_writes.load();
+    stats.bytes_written = bytes_written.load();
+    stats.syncs = syncs.load();
+    stats.growth_events = growth_events.load();
+    stats.growth_ns = growth_ns.load();
+    return stats;
+}
+
+void processPageFaults(std::uint64_t* minor, std::uint64_t* major) {
+    struct rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    *minor = usage.ru_minflt;
+    *major = usage.ru_majflt;
+}
+
+std::string formatStats(const ReaderStats& stats) {
+    std::ostringstream out;
+    out << "lock_checks=" << stats.lock_checks
+        << " lock_wait_ns=" << stats.lock_wait_ns
+        << " file_checks=" << stats.file_checks
+        << " remaps=" << stats.remaps
+        << " bytes_served=" << stats.bytes_served
+        << " snapshot_reads=" << stats.snapshot_reads
+        << " minor_faults=" << stats.minor_faults
+        << " major_faults=" << stats.major_faults;
+    return out.str();
+}
+
+std::string formatStats(const WriterStats& stats) {
+    std::ostringstream out;
+    out << "write_calls=" << stats.write_calls
+        << " batch_writes=" << stats.batch_writes
+        << " bytes_written=" << stats.bytes_written
+        << " syncs=" << stats.syncs
+        << " growth_events=" << stats.growth_events
+        << " growth_ns=" << stats.growth_ns;
+    return out.str();
+}
+
+PeriodicStatsDump::PeriodicStatsDump(std::function<std::string()> snapshot, std::chrono::milliseconds interval,
+                                     std::ostream& out)
+    : stopping(false) {
+    worker = std::thread([this, snapshot, interval, &out]() {
+        std::unique_lock<std::mutex> guard(lock);
+        while (!wake.wait_for(guard, interval, [this]() { return stopping; })) {
+            out << "[stats] " << snapshot() << std::endl;
+        }
+    });
+}
+
+PeriodicStatsDump::~PeriodicStatsDump() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
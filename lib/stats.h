@@ -0,0 +1,108 @@
+#ifndef STATS_H
+#define STATS_H
+
+/*
+    * Stats
+    * Hot-path counters of the readers and writers. Each counter is a relaxed
+    * atomic owned by one reader or writer, so counting costs an uncontended
+    * add and never orders or synchronizes anything; leaving them enabled does
+    * not change what is being measured. stats() takes a snapshot.
+    *
+    * PeriodicStatsDump prints snapshots from a background thread:
+    *
+    *     PeriodicStatsDump dump([&] { return formatStats(reader.stats()); },
+    *                            std::chrono::seconds(1));
+*/
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+class StatCounter {
+    private:
+        std::atomic<std::uint64_t> value{0};
+
+    public:
+        void add(std::uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+        std::uint64_t load() const { return value.load(std::memory_order_relaxed); }
+};
+
+struct ReaderStats {
+    std::uint64_t lock_checks = 0;     // readLockfile calls
+    std::uint64_t lock_wait_ns = 0;    // Time spent waiting for the writer to unlock
+    std::uint64_t file_checks = 0;     // fstat/stat calls validating the data file
+    std::uint64_t remaps = 0;          // Data file remapped: replaced file or moved reservation
+    std::uint64_t bytes_served = 0;    // Bytes returned by view, readData and the operators
+    std::uint64_t snapshot_reads = 0;  // Accesses below the snapshot, served without coordination
+    // Page faults of the whole process since the reader was opened; the
+    // kernel does not attribute them to a mapping
+    std::uint64_t minor_faults = 0;
+    std::uint64_t major_faults = 0;
+};
+
+struct WriterStats {
+    std::uint64_t write_calls = 0;     // writeData calls
+    std::uint64_t batch_writes = 0;    // Lock/write/unlock cycles (writeBatch, unbatched writeData)
+    std::uint64_t bytes_written = 0;
+    std::uint64_t syncs = 0;           // fdatasync, msync or cache-line flush rounds
+    std::uint64_t growth_events = 0;   // famfs copy-to-grow cycles
+    std::uint64_t growth_ns = 0;       // Time spent in them
+};
+
+// Live counters behind ReaderStats
+struct ReaderCounters {
+    StatCounter lock_checks;
+    StatCounter lock_wait_ns;
+    StatCounter file_checks;
+    StatCounter remaps;
+    StatCounter bytes_served;
+    StatCounter snapshot_reads;
+};
+
+// Live counters behind WriterStats
+struct WriterCounters {
+    StatCounter write_calls;
+    StatCounter batch_writes;
+    StatCounter bytes_written;
+    StatCounter syncs;
+    StatCounter growth_events;
+    StatCounter growth_ns;
+
+    WriterStats snapshot() const;
+};
+
+// Minor and major page faults of the process so far
+void processPageFaults(std::uint64_t* minor, std::uint64_t* major);
+
+inline std::uint64_t nanosecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+// One line of "name=value" pairs
+std::string formatStats(const ReaderStats& stats);
+std::string formatStats(const WriterStats& stats);
+
+// Write snapshot() to out every interval until destroyed
+class PeriodicStatsDump {
+    private:
+        std::mutex lock;
+        std::condition_variable wake;
+        bool stopping;
+        std::thread worker;
+
+    public:
+        PeriodicStatsDump(std::function<std::string()> snapshot, std::chrono::milliseconds interval,
+                          std::ostream& out = std::cerr);
+        ~PeriodicStatsDump();
+
+        PeriodicStatsDump(const PeriodicStatsDump&) = delete;
+        PeriodicStatsDump& operator=(const PeriodicStatsDump&) = delete;
+};
+
+#endif // STATS_H
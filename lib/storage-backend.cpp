@@ -0,0 +1,62 @@
+#include "storage-backend.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/vfs.h>
+
+#ifndef STATX_ATTR_DAX
+#define STATX_ATTR_DAX 0x00200000  // Linux 5.8
+#endif
+
+struct KnownFilesystem {
+    std::uint64_t magic;
+    const char* name;
+    bool block_backed;   // Pages come from a block device through the page cache
+};
+
+static const KnownFilesystem KNOWN_FILESYSTEMS[] = {
+    { 0x01021994, "tmpfs", false },
+    { 0x858458f6, "ramfs", false },
+    { 0x958458f6, "hugetlbfs", false },
+    { 0x0000ef53, "ext4", true },       // Also ext2/ext3
+    { 0x58465342, "xfs", true },
+    { 0x9123683e, "btrfs", true },
+    { 0xf2f52010, "f2fs", true },
+    { 0x794c7630, "overlayfs", false }, // Backing unknown: keep mapping
+    { 0x00006969, "nfs", false },
+};
+
+StorageInfo detectStorage(int fd) {
+    StorageInfo info;
+    struct statx file_statx;
+    if (statx(fd, "", AT_EMPTY_PATH, STATX_BASIC_STATS, &file_statx) == 0) {
+        info.dax = (file_statx.stx_attributes_mask & STATX_ATTR_DAX)
+            && (file_statx.stx_attributes & STATX_ATTR_DAX);
+    }
+    struct statfs fs_stat;
+    if (fstatfs(fd, &fs_stat) == 0) {
+        info.fs_magic = static_cast<std::uint64_t>(fs_stat.f_type) & 0xffffffffULL;
+    }
+    bool block_backed = false;
+    for (const KnownFilesystem& fs : KNOWN_FILESYSTEMS) {
+        if (fs.magic == info.fs_magic) {
+            info.fs_name = fs.name;
+            block_backed = fs.block_backed;
+            break;
+        }
+    }
+    info.preferred = (block_backed && !info.dax) ? ReadBackend::IoUring : ReadBackend::Mmap;
+    return info;
+}
+
+const char* backendName(ReadBackend backend) {
+    switch (backend) {
+        case ReadBackend::Auto:
+            return "auto";
+        case ReadBackend::Mmap:
+            return "mmap";
+        case ReadBackend::IoUring:
+            return "io_uring";
+    }
+    return "unknown";
+}
@@ -0,0 +1,36 @@
+#ifndef STORAGE_BACKEND_H
+#define STORAGE_BACKEND_H
+
+/*
+    * Storage Backend
+    * Works out what a data file lives on, so a reader can pick how to read
+    * it. Files on DAX (famfs, fs-dax on pmem/CXL) or in memory (tmpfs) are
+    * mapped: a fault only installs a page table entry. Files on block
+    * filesystems without DAX (ext4, xfs, btrfs staging copies) fault every
+    * page through the page cache; for cold data on a real device, batched
+    * asynchronous reads into a buffer can be faster.
+*/
+
+#include <cstdint>
+
+// How ZeroCopyRead gets at the bytes of the data file
+enum class ReadBackend {
+    Auto,      // Decide from detectStorage()
+    Mmap,      // Map the file (zero copy)
+    IoUring    // Read it into an anonymous buffer with io_uring (pread fallback)
+};
+
+struct StorageInfo {
+    bool dax = false;                // statx reports STATX_ATTR_DAX
+    std::uint64_t fs_magic = 0;      // statfs f_type
+    const char* fs_name = "unknown";
+    ReadBackend preferred = ReadBackend::Mmap;
+};
+
+// Inspect the file behind fd. Filesystems it does not recognize are
+// reported as preferring Mmap, the behaviour before detection existed.
+StorageInfo detectStorage(int fd);
+
+const char* backendName(ReadBackend backend);
+
+#endif // STORAGE_BACKEND_H
@@ -0,0 +1,147 @@
+#ifndef TYPED_VIEW_H
+#define TYPED_VIEW_H
+
+/*
+    * Typed Views
+    * Treat a range of a ZeroCopyRead mapping as an array of fixed-width
+    * records. Bounds are validated and the writer lock is checked once, at
+    * construction; element access afterwards is a plain unaligned-safe load
+    * (memcpy) that the compiler can vectorize.
+    *
+    *     TypedView<int32_t> values(reader, header_size);
+    *     int64_t sum = std::accumulate(values.begin(), values.end(), int64_t(0));
+    *
+    * StridedView<T> reads one T every `stride` bytes, e.g. one field of an
+    * array of structs.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "zero-copy-read-library.h"
+
+static constexpr size_t TYPED_VIEW_ALL = static_cast<size_t>(-1);
+
+template <typename T>
+class StridedView {
+    static_assert(std::is_trivially_copyable<T>::value, "TypedView elements must be trivially copyable");
+
+    protected:
+        const char* data_;
+        size_t count_;
+        size_t stride_;
+
+    public:
+        // count elements of T, one every stride bytes, starting at offset.
+        // TYPED_VIEW_ALL takes as many whole elements as fit in the file.
+        StridedView(ZeroCopyRead& reader, size_t offset, size_t stride, size_t count = TYPED_VIEW_ALL)
+            : data_(nullptr), count_(0), stride_(stride) {
+            if (stride_ < sizeof(T)) {
+                throw std::runtime_error("Stride is smaller than the element type");
+            }
+            size_t file_size = reader.getFileSize();
+            if (offset > file_size) {
+                throw std::runtime_error("TypedView offset is past the end of the file");
+            }
+            size_t available = file_size - offset < sizeof(T)
+                ? 0 : (file_size - offset - sizeof(T)) / stride_ + 1;
+            if (count == TYPED_VIEW_ALL) {
+                count = available;
+            } else if (count > available) {
+                throw std::runtime_error("TypedView range is past the end of the file");
+            }
+            count_ = count;
+            if (count_ > 0) {
+                std::string_view range = reader.view(offset, (count_ - 1) * stride_ + sizeof(T));
+                data_ = range.data();
+            }
+        }
+
+        class iterator {
+            private:
+                const char* ptr_;
+                size_t stride_;
+
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = T;
+                using difference_type = std::ptrdiff_t;
+                using pointer = void;
+                using reference = T;
+
+                iterator(const char* ptr, size_t stride) : ptr_(ptr), stride_(stride) {}
+
+                T operator*() const {
+                    T value;
+                    memcpy(&value, ptr_, sizeof(T));
+                    return value;
+                }
+                T operator[](difference_type n) const { return *(*this + n); }
+
+                iterator& operator++() { ptr_ += stride_; return *this; }
+                iterator operator++(int) { iterator old = *this; ptr_ += stride_; return old; }
+                iterator& operator--() { ptr_ -= stride_; return *this; }
+                iterator operator--(int) { iterator old = *this; ptr_ -= stride_; return old; }
+                iterator& operator+=(difference_type n) { ptr_ += n * static_cast<difference_type>(stride_); return *this; }
+                iterator& operator-=(difference_type n) { ptr_ -= n * static_cast<difference_type>(stride_); return *this; }
+                iterator operator+(difference_type n) const { iterator it = *this; return it += n; }
+                iterator operator-(difference_type n) const { iterator it = *this; return it -= n; }
+                difference_type operator-(const iterator& other) const {
+                    return (ptr_ - other.ptr_) / static_cast<difference_type>(stride_);
+                }
+
+                bool operator==(const iterator& other) const { return ptr_ == other.ptr_; }
+                bool operator!=(const iterator& other) const { return ptr_ != other.ptr_; }
+                bool operator<(const iterator& other) const { return ptr_ < other.ptr_; }
+                bool operator>(const iterator& other) const { return ptr_ > other.ptr_; }
+                bool operator<=(const iterator& other) const { return ptr_ <= other.ptr_; }
+                bool operator>=(const iterator& other) const { return ptr_ >= other.ptr_; }
+        };
+
+        size_t size() const { return count_; }
+        bool empty() const { return count_ == 0; }
+        size_t stride() const { return stride_; }
+
+        // Unchecked element access; the range was validated at construction
+        T operator[](size_t i) const {
+            T value;
+            memcpy(&value, data_ + i * stride_, sizeof(T));
+            return value;
+        }
+
+        T at(size_t i) const {
+            if (i >= count_) {
+                throw std::runtime_error("TypedView index out of range");
+            }
+            return (*this)[i];
+        }
+
+        iterator begin() const { return iterator(data_, stride_); }
+        iterator end() const { return iterator(data_ + count_ * stride_, stride_); }
+
+        // Whether every element is naturally aligned for T
+        bool isAligned() const {
+            return reinterpret_cast<std::uintptr_t>(data_) % alignof(T) == 0 && stride_ % alignof(T) == 0;
+        }
+};
+
+template <typename T>
+class TypedView : public StridedView<T> {
+    public:
+        // count elements of T packed back to back starting at offset
+        explicit TypedView(ZeroCopyRead& reader, size_t offset = 0, size_t count = TYPED_VIEW_ALL)
+            : StridedView<T>(reader, offset, sizeof(T), count) {}
+
+        // Direct pointer to the elements when they are aligned, nullptr
+        // otherwise. Loops over it vectorize like loops over any array.
+        const T* alignedData() const {
+            return this->isAligned() ? reinterpret_cast<const T*>(this->data_) : nullptr;
+        }
+};
+
+#endif // TYPED_VIEW_H
@@ -1,7 +1,15 @@
 #include "write-library.h"
 
+#include <algorithm>
+#include <climits>
+#include <system_error>
+
+#include "frame-format.h"
+
 WriteLibrary::WriteLibrary(const char* file_path, const char* lock_file_path)
-    : file_path_(file_path), lock_file_path_(lock_file_path), size_written(0) {
+    : size_written(0), file_path_(file_path), lock_file_path_(lock_file_path),
+      unsynced_bytes(0), last_sync(std::chrono::steady_clock::now()), in_batch(false), sealed(false),
+      stop_flusher(false) {
     // Open the data file
     fd = open(file_path_.c_str(), O_WRONLY);
     if (fd < 0) {
@@ -25,6 +33,7 @@ WriteLibrary::WriteLibrary(const char* file_path, const char* lock_file_path)
         std::cerr << "Warning: File is empty, no data to write." << std::endl;
     }
     size_written = 0;
+    committed_length = file_stat.st_size;
 
     // Open the lock file
     lock_fd = open(lock_file_path_.c_str(), O_RDWR);
@@ -39,9 +48,40 @@ WriteLibrary::WriteLibrary(const char* file_path, const char* lock_file_path)
 
     file_path_ = file_path;
     lock_file_path_ = lock_file_path;
+
+    try {
+        control_block = mapControlBlock(lock_fd);
+    } catch (...) {
+        close(fd);
+        close(lock_fd);
+        throw;
+    }
+    claimControlBlock(control_block);
+    std::uint64_t sealed_length;
+    if (readSealMarker(fd, &sealed_length)) {
+        // Sealed by an earlier writer: keep telling readers, and refuse writes
+        sealed = true;
+        committed_length = std::min<size_t>(committed_length, sealed_length);
+    } else if (!clearSealMarker(fd)) {
+        perror("Failed to remove stale seal marker");  // Readers ignore it anyway
+    }
+    publishFileIdentity(control_block, fd, committed_length, lock_fd, sealed ? CONTROL_BLOCK_SEALED : 0);
 }
 
 WriteLibrary::~WriteLibrary() {
+    stopFlusher();
+    if (in_batch && !batch_buffer.empty()) {
+        try {
+            commit();
+        } catch (const std::exception& ex) {
+            std::cerr << "Failed to commit batch: " << ex.what() << std::endl;
+        }
+    }
+    if (unsynced_bytes > 0 && durability_.mode != Durability::None) {
+        fdatasync(fd);
+        counters_.syncs.add();
+    }
+    unmapControlBlock(control_block);
     if (fd >= 0) {
         close(fd);
     }
@@ -51,34 +91,17 @@ WriteLibrary::~WriteLibrary() {
 }
 
 void WriteLibrary::lockFile() {
-    std::string msg = file_path_+ "\n";
-    lseek(lock_fd, 0, SEEK_SET);
-    ftruncate(lock_fd, 0);
-    write(lock_fd, msg.data(), msg.size());
-    fsync(lock_fd);    // ensure readers see it
-    if (fsync(lock_fd) < 0) {
-        close(lock_fd);
-        throw std::system_error(errno, std::generic_category(), "fsync");
-    }
+    // Seqlock write side: an odd sequence tells readers an update is in progress
+    beginControlBlockWrite(control_block);
 }
 
 void WriteLibrary::unlockFile() {
-    std::string msg = file_path_+ "\n";
-    std::vector<char> zeros(msg.size(), 0);
-    write(lock_fd, zeros.data(), zeros.size());
-    lseek(lock_fd, 0, SEEK_SET);
-    ftruncate(lock_fd, 0);
-    fsync(lock_fd);    // ensure readers see it
-    if (fsync(lock_fd) < 0) {
-        close(lock_fd);
-        throw std::system_error(errno, std::generic_category(), "fsync");
-    }
+    endControlBlockWrite(control_block, committed_length, lock_fd);
 }
 
-void WriteLibrary::writeData(const char* data, size_t size) {
-    lockFile();
+void WriteLibrary::ensureCapacity(size_t size) {
     while (size + size_written > file_size) {
-
+        auto growth_start = std::chrono::steady_clock::now();
         std::string cmd = "sudo cp " + file_path_ + " /tmp/tmpfile";
         close(fd);
         int ret = std::system(cmd.c_str());
@@ -118,14 +141,271 @@ void WriteLibrary::writeData(const char* data, size_t size) {
             std::cerr << "Warning: File is empty after copy, no data to write." << std::endl;
         }
         size_written = 0;
+        if (lseek(fd, 0, SEEK_END) < 0) {
+            perror("lseek");
+        }
+        // The data file was replaced: readers must remap the new inode
+        publishFileIdentity(control_block, fd, committed_length, lock_fd);
+        counters_.growth_events.add();
+        counters_.growth_ns.add(nanosecondsSince(growth_start));
     }
+}
 
-    ssize_t bytes_written = write(fd, data, size);
-    if (bytes_written < 0) {
-        perror("Failed to write data");
-        throw std::runtime_error("Failed to write data");
+size_t WriteLibrary::writeAll(const struct iovec* iov, int iovcnt) {
+    size_t total = 0;
+    while (iovcnt > 0) {
+        int count = iovcnt < IOV_MAX ? iovcnt : IOV_MAX;
+        ssize_t bytes_written = writev(fd, iov, count);
+        if (bytes_written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("Failed to write data");
+            throw std::runtime_error("Failed to write data");
+        }
+        total += bytes_written;
+        // Skip the iovecs written completely
+        size_t remaining = bytes_written;
+        while (iovcnt > 0 && remaining >= iov->iov_len) {
+            remaining -= iov->iov_len;
+            iov++;
+            iovcnt--;
+        }
+        if (remaining == 0) {
+            continue;
+        }
+        // Short write: finish the partial iovec before going back to writev
+        const char* rest = static_cast<const char*>(iov->iov_base) + remaining;
+        size_t rest_len = iov->iov_len - remaining;
+        while (rest_len > 0) {
+            ssize_t n = write(fd, rest, rest_len);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("Failed to write data");
+                throw std::runtime_error("Failed to write data");
+            }
+            rest += n;
+            rest_len -= n;
+            total += n;
+        }
+        iov++;
+        iovcnt--;
+    }
+    return total;
+}
+
+void WriteLibrary::syncAfterWrite(size_t size) {
+    unsynced_bytes += size;
+    bool sync = false;
+    switch (durability_.mode) {
+        case Durability::None:
+            return;
+        case Durability::PerBatch:
+            sync = true;
+            break;
+        case Durability::GroupCommit:
+            sync = unsynced_bytes >= durability_.group_commit_bytes
+                || std::chrono::steady_clock::now() - last_sync >= durability_.group_commit_interval;
+            break;
+    }
+    if (sync) {
+        flushLocked();
     }
+}
 
+void WriteLibrary::flush() {
+    std::lock_guard<std::mutex> guard(sync_mutex);
+    flushLocked();
+}
+
+void WriteLibrary::flushLocked() {
+    if (unsynced_bytes == 0) {
+        return;
+    }
+    if (fdatasync(fd) < 0) {
+        throw std::system_error(errno, std::generic_category(), "fdatasync");
+    }
+    unsynced_bytes = 0;
+    last_sync = std::chrono::steady_clock::now();
+    counters_.syncs.add();
+}
+
+void WriteLibrary::setDurability(const DurabilityOptions& options) {
+    stopFlusher();
+    {
+        std::lock_guard<std::mutex> guard(sync_mutex);
+        durability_ = options;
+    }
+    if (options.mode == Durability::GroupCommit) {
+        stop_flusher = false;
+        flusher = std::thread(&WriteLibrary::runFlusher, this);
+    }
+}
+
+void WriteLibrary::stopFlusher() {
+    if (!flusher.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> guard(sync_mutex);
+        stop_flusher = true;
+    }
+    flusher_wake.notify_one();
+    flusher.join();
+}
+
+void WriteLibrary::runFlusher() {
+    std::unique_lock<std::mutex> lock(sync_mutex);
+    while (!stop_flusher) {
+        // Wake when the oldest unsynced data reaches the interval
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = unsynced_bytes > 0 ? last_sync + durability_.group_commit_interval
+                                           : now + durability_.group_commit_interval;
+        flusher_wake.wait_until(lock, deadline);
+        if (stop_flusher) {
+            break;
+        }
+        if (unsynced_bytes > 0
+            && std::chrono::steady_clock::now() - last_sync >= durability_.group_commit_interval) {
+            try {
+                flushLocked();
+            } catch (const std::exception& ex) {
+                std::cerr << "Group commit failed: " << ex.what() << std::endl;
+            }
+        }
+    }
+}
+
+void WriteLibrary::writeData(const char* data, size_t size) {
+    if (sealed) {
+        throw std::runtime_error("Data file is sealed");
+    }
+    counters_.write_calls.add();
+    if (in_batch) {
+        batch_buffer.append(data, size);
+        return;
+    }
+    struct iovec iov = { const_cast<char*>(data), size };
+    writeBatch(&iov, 1);
+}
+
+void WriteLibrary::writeBatch(const struct iovec* iov, int iovcnt) {
+    if (sealed) {
+        throw std::runtime_error("Data file is sealed");
+    }
+    if (in_batch) {
+        for (int i = 0; i < iovcnt; ++i) {
+            batch_buffer.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+        }
+        return;
+    }
+    size_t size = 0;
+    for (int i = 0; i < iovcnt; ++i) {
+        size += iov[i].iov_len;
+    }
+
+    // ensureCapacity may reopen fd: keep the flusher out until the sync
+    std::lock_guard<std::mutex> guard(sync_mutex);
+    lockFile();
+    size_t bytes_written;
+    try {
+        ensureCapacity(size);
+        bytes_written = writeAll(iov, iovcnt);
+    } catch (...) {
+        unlockFile();
+        throw;
+    }
     size_written += bytes_written;
+    committed_length += bytes_written;
+    unlockFile();
+    counters_.batch_writes.add();
+    counters_.bytes_written.add(bytes_written);
+
+    syncAfterWrite(bytes_written);
+}
+
+void WriteLibrary::writeFrame(const void* payload, size_t size, std::uint32_t type) {
+    if (size > UINT32_MAX) {
+        throw std::invalid_argument("Frame payload must be smaller than 4 GiB");
+    }
+    if (sealed) {
+        throw std::runtime_error("Data file is sealed");
+    }
+    FrameHeader header = makeFrameHeader(payload, static_cast<std::uint32_t>(size), type);
+    counters_.write_calls.add();
+    if (in_batch) {
+        batch_buffer.append(reinterpret_cast<const char*>(&header), sizeof(header));
+        batch_buffer.append(static_cast<const char*>(payload), size);
+        return;
+    }
+    struct iovec iov[2] = {
+        { &header, sizeof(header) },
+        { const_cast<void*>(payload), size }
+    };
+    writeBatch(iov, 2);
+}
+
+void WriteLibrary::beginBatch() {
+    in_batch = true;
+    batch_buffer.clear();  // Keeps its capacity across batches
+}
+
+void WriteLibrary::commit() {
+    in_batch = false;
+    if (!batch_buffer.empty()) {
+        struct iovec iov = { batch_buffer.data(), batch_buffer.size() };
+        writeBatch(&iov, 1);
+        batch_buffer.clear();
+    }
+}
+
+bool WriteLibrary::seal(bool enforce) {
+    if (in_batch) {
+        commit();
+    }
+    if (!sealed) {
+        // The data has to be durable before a marker that says it is final
+        std::lock_guard<std::mutex> guard(sync_mutex);
+        if (fdatasync(fd) < 0) {
+            throw std::system_error(errno, std::generic_category(), "fdatasync");
+        }
+        unsynced_bytes = 0;
+        last_sync = std::chrono::steady_clock::now();
+        counters_.syncs.add();
+        if (!writeSealMarker(fd, committed_length)) {
+            perror("Failed to store seal marker");  // The control block still carries the seal
+        }
+        lockFile();
+        control_block->flags.fetch_or(CONTROL_BLOCK_SEALED, std::memory_order_relaxed);
+        unlockFile();  // Releases the flag with the final length, wakes followers
+        if (msync(control_block, sizeof(ControlBlock), MS_SYNC) == -1) {
+            perror("msync failed");
+        }
+        sealed = true;
+    }
+    if (!enforce) {
+        return false;
+    }
+    // Only memfd and shmem files take seals
+    return fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0;
+}
+
+void WriteLibrary::unseal() {
+    if (!sealed) {
+        return;
+    }
+    int seals = fcntl(fd, F_GET_SEALS);
+    if (seals != -1 && (seals & F_SEAL_WRITE)) {
+        throw std::runtime_error("The kernel enforces the seal, the file cannot be unsealed");
+    }
+    if (!clearSealMarker(fd)) {
+        perror("Failed to remove seal marker");
+        throw std::runtime_error("Failed to remove seal marker");
+    }
+    lockFile();
+    control_block->flags.fetch_and(~CONTROL_BLOCK_SEALED, std::memory_order_relaxed);
     unlockFile();
+    sealed = false;
 }
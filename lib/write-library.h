@@ -11,20 +11,70 @@
 #include <unistd.h>   // for ftruncate
 #include <cstdint> 
 #include <sys/mman.h>
+#include <sys/uio.h>  // for struct iovec
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
 #include <vector>
 
+#include "control-block.h"
+#include "stats.h"
+
 static constexpr std::uint64_t BLOCK_SIZE = 2ULL * 1024 * 1024;
 #define INCREASE_BLOCK 1
 #define MAX_BUFFER_SIZE 1024
 
+// When written data is flushed to the storage with fdatasync
+enum class Durability {
+    None,        // Never; visibility to readers does not need it
+    PerBatch,    // After every writeData, writeBatch or commit
+    GroupCommit  // Once enough bytes or time have accumulated
+};
+
+struct DurabilityOptions {
+    Durability mode = Durability::None;
+    // GroupCommit: sync when either bound is reached. The interval also
+    // holds for an idle writer: a background thread syncs data left
+    // unsynced for longer than it.
+    size_t group_commit_bytes = 1 << 20;
+    std::chrono::milliseconds group_commit_interval = std::chrono::milliseconds(10);
+};
+
 class WriteLibrary {
     private:
         int fd;                        // File descriptor for the data file
         int lock_fd;                // File descriptor for the lock file
         size_t file_size;            // Size of the file
         size_t size_written;
+        size_t committed_length;     // Logical length of the data file published to readers
         std::string file_path_;      // Path to the data file
         std::string lock_file_path_; // Path to the lock file
+        ControlBlock* control_block;   // Shared control block mapped from the lock file
+        DurabilityOptions durability_;
+        size_t unsynced_bytes;       // Bytes written since the last fdatasync
+        std::chrono::steady_clock::time_point last_sync;
+        bool in_batch;
+        std::string batch_buffer;    // Records staged between beginBatch() and commit()
+        bool sealed;                 // seal() was called, or the file was sealed before
+        WriterCounters counters_;
+        std::mutex sync_mutex;       // Serializes writes and syncs with the flusher thread
+        std::condition_variable flusher_wake;
+        std::thread flusher;         // Runs while the mode is GroupCommit
+        bool stop_flusher;
+
+        // Grow the data file (famfs copy) until size more bytes fit
+        void ensureCapacity(size_t size);
+        // Write all iovecs at the end of the file; returns the bytes written
+        size_t writeAll(const struct iovec* iov, int iovcnt);
+        // Apply the durability policy after size bytes were committed
+        void syncAfterWrite(size_t size);
+        // flush() with sync_mutex held
+        void flushLocked();
+        // GroupCommit flusher: sync data left idle for the interval
+        void runFlusher();
+        void stopFlusher();
 
     public:
         // Constructor
@@ -39,9 +89,48 @@ class WriteLibrary {
         // Method to unlock the file after writing
         void unlockFile();
         
-        // Method to write data to the file
+        // Method to write data to the file. Between beginBatch() and commit()
+        // the data is only staged.
         void writeData(const char* data, size_t size);
 
+        // Write several records under a single lock/unlock cycle and a
+        // single durability check. Between beginBatch() and commit() the
+        // records are staged after the ones already staged.
+        void writeBatch(const struct iovec* iov, int iovcnt);
+
+        // Write payload as one checksummed frame (frame-format.h), header
+        // and payload under one lock/unlock cycle. Staged like writeData
+        // between beginBatch() and commit(). Throws std::invalid_argument for
+        // payloads of 4 GiB or more.
+        void writeFrame(const void* payload, size_t size, std::uint32_t type = 0);
+
+        // Stage the following writeData, writeBatch and writeFrame calls and
+        // publish them together, in order, on commit(). Readers are not blocked while the batch is staged.
+        void beginBatch();
+        void commit();
+
+        void setDurability(const DurabilityOptions& options);
+        // fdatasync any data not yet synced under the durability policy
+        void flush();
+
+        // Finish the file: commit any staged batch, fdatasync the data, then
+        // record the final length as the seal marker on the data file and in
+        // the control block, and wake the readers. Readers that see the seal
+        // stop checking the lock and the file. Writes after it throw.
+        // With enforce, the kernel is also asked to refuse changes with
+        // F_ADD_SEALS, which only files that support seals (memfd) take.
+        // Returns whether enforcement applied.
+        bool seal(bool enforce = false);
+        bool isSealed() const { return sealed; }
+        // Reopen a sealed file for writes: remove the marker and the flag.
+        // Readers opened from now on coordinate again; readers that already
+        // saw the seal keep their final length and must be reopened. Throws
+        // if the kernel enforces the seal.
+        void unseal();
+
+        // Snapshot of the hot-path counters (stats.h)
+        WriterStats stats() const { return counters_.snapshot(); }
+
 };
 
 #endif // WRITE_LIBRARY_H
\ No newline at end of file
@@ -1,6 +1,70 @@
 #include "zero-copy-read-library.h"
 
-ZeroCopyRead::ZeroCopyRead(const char* file_path, const char* lock_file_path) : current_position(0), ready(false) {
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+
+#ifndef MADV_POPULATE_READ
+#define MADV_POPULATE_READ 22  // Linux 5.14
+#endif
+
+static size_t pageSize() {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    return page_size;
+}
+
+static size_t roundUpToPage(size_t size) {
+    return (size + pageSize() - 1) & ~(pageSize() - 1);
+}
+
+// Reserve PROT_NONE address space, aligned to HUGE_PAGE_SIZE if huge_pages
+static void* reserveAddressSpace(size_t size, bool huge_pages) {
+    size_t slack = huge_pages ? HUGE_PAGE_SIZE : 0;
+    void* base = mmap(nullptr, size + slack, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (base == MAP_FAILED || slack == 0) {
+        return base;
+    }
+    // Trim the unaligned head and the tail of the over-sized reservation
+    char* start = static_cast<char*>(base);
+    char* aligned = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(start) + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1));
+    if (aligned > start) {
+        munmap(start, aligned - start);
+    }
+    if (start + slack > aligned) {
+        munmap(aligned + size, start + slack - aligned);
+    }
+    return aligned;
+}
+
+ZeroCopyReadBase::ZeroCopyReadBase(const char* file_path, const char* lock_file_path,
+                               const ZeroCopyReadOptions& options)
+    : current_position(0), owns_control_block(true), options_(options), mapped_size(0),
+      reserved_size(0), prefetched_until(0), snapshot_length(0), sealed_(false), ready(false) {
+    lock_file_path_ = lock_file_path;
+    lock_fd = open(lock_file_path_.c_str(), O_RDWR);
+    if (lock_fd == -1) {
+        perror("Failed to open lock file");
+        throw std::runtime_error("Failed to open lock file");
+    }
+    control_block = mapControlBlock(lock_fd);
+    waiter_.watchLockFile(lock_fd);
+    mapDataFile(file_path);
+    detectSeal();
+}
+
+ZeroCopyReadBase::ZeroCopyReadBase(const char* file_path, ControlBlock* shared_control_block,
+                               const ZeroCopyReadOptions& options)
+    : lock_fd(-1), current_position(0), control_block(shared_control_block), owns_control_block(false),
+      options_(options), mapped_size(0), reserved_size(0), prefetched_until(0), snapshot_length(0),
+      sealed_(false), ready(false) {
+    mapDataFile(file_path);
+    detectSeal();
+}
+
+void ZeroCopyReadBase::mapDataFile(const char* file_path) {
+    processPageFaults(&opened_minor_faults, &opened_major_faults);
     struct stat file_stat;
     fd = open(file_path, O_RDONLY);
     if (fd == -1) {
@@ -12,202 +76,489 @@ ZeroCopyRead::ZeroCopyRead(const char* file_path, const char* lock_file_path) :
         throw std::runtime_error("Failed to get file size");
     }
     file_size = file_stat.st_size;
+    file_dev = file_stat.st_dev;
+    file_ino = file_stat.st_ino;
     file_path_ = file_path;
-    lock_file_path_ = lock_file_path;
 
-    lock_fd = open(lock_file_path_.c_str(), O_RDWR);
-    if (lock_fd == -1) {
-        perror("Failed to open lock file");
-        throw std::runtime_error("Failed to open lock file");
+    backend_ = options_.backend;
+    if (backend_ == ReadBackend::Auto) {
+        backend_ = options_.follow ? ReadBackend::Mmap : detectStorage(fd).preferred;
+    }
+    IoEngineOptions engine_options = options_.io_engine;
+    if (options_.access == AccessPattern::Random) {
+        engine_options.readahead = 0;
+    }
+
+    if (options_.follow) {
+        // Reserve address space only; file pages are mapped into it as the
+        // file grows
+        reserved_size = roundUpToPage(std::max(options_.reserve_size, file_size));
+        base_mmap_ptr = reserveAddressSpace(reserved_size, options_.huge_pages);
+        if (base_mmap_ptr == MAP_FAILED) {
+            perror("mmap failed");
+            throw std::runtime_error("Failed to reserve address space");
+        }
+        iter_mmap_ptr = static_cast<char*>(base_mmap_ptr);
+        file_size = 0;
+        if (backend_ == ReadBackend::IoUring) {
+            // The buffer grows with the file: registering it would pin it
+            // again on every growth
+            engine_options.register_buffer = false;
+            engine_ = std::make_unique<IoUringEngine>(fd, static_cast<char*>(base_mmap_ptr), 0,
+                                                      engine_options);
+        }
+        extendMapping(file_stat.st_size);
+        return;
     }
 
     if (file_size == 0) {
         throw std::runtime_error("Cannot mmap empty file");
     }
 
-    base_mmap_ptr = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (backend_ == ReadBackend::IoUring) {
+        reserved_size = options_.huge_pages
+            ? (file_size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1)
+            : roundUpToPage(file_size);
+        base_mmap_ptr = reserveAddressSpace(reserved_size, options_.huge_pages);
+        if (base_mmap_ptr == MAP_FAILED) {
+            perror("mmap failed");
+            throw std::runtime_error("Failed to reserve address space");
+        }
+        mapBuffer(0, roundUpToPage(file_size));
+        mapped_size = file_size;
+        iter_mmap_ptr = static_cast<char*>(base_mmap_ptr);
+        engine_ = std::make_unique<IoUringEngine>(fd, static_cast<char*>(base_mmap_ptr), mapped_size,
+                                                  engine_options);
+        // Only read what the writer has committed: a block read past it
+        // would keep the stale bytes
+        if (controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+            file_size = std::min(file_size, getCommittedLength());
+        }
+        adviseMapping(0, mapped_size);
+        if (options_.populate) {
+            engine_->load(0, file_size, file_size);
+        }
+        return;
+    }
+
+    int flags = MAP_PRIVATE | (options_.populate ? MAP_POPULATE : 0);
+    void* address = nullptr;
+    reserved_size = file_size;
+    if (options_.huge_pages) {
+        // Map the file over a 2 MiB-aligned reservation so file offsets and
+        // addresses share their huge page alignment
+        reserved_size = (file_size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        address = reserveAddressSpace(reserved_size, true);
+        if (address == MAP_FAILED) {
+            perror("mmap failed");
+            throw std::runtime_error("Failed to reserve address space");
+        }
+        flags |= MAP_FIXED;
+    }
+    base_mmap_ptr = mmap(address, file_size, PROT_READ, flags, fd, 0);
     if (base_mmap_ptr == MAP_FAILED) {
         perror("mmap failed");
+        if (address != nullptr) {
+            munmap(address, reserved_size);
+        }
         throw std::runtime_error("Failed to mmap file");
     }
+    mapped_size = file_size;
     iter_mmap_ptr = static_cast<char*>(base_mmap_ptr);
+    adviseMapping(0, mapped_size);
+
+    // A preallocated file written through a mapping is only valid up to the
+    // committed length
+    if (controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+        file_size = std::min(file_size, getCommittedLength());
+    }
 }
 
-ZeroCopyRead::~ZeroCopyRead() {
+ZeroCopyReadBase::~ZeroCopyReadBase() {
+    engine_.reset();  // Waits for reads into the buffer
     if (base_mmap_ptr != MAP_FAILED) {
-        munmap(base_mmap_ptr, file_size);
+        munmap(base_mmap_ptr, reserved_size);
+    }
+    if (owns_control_block) {
+        unmapControlBlock(control_block);
+        close(lock_fd);
     }
     close(fd);
 }
 
-size_t ZeroCopyRead::atomicReadLine(char* buffer) {
-    struct stat file_stat;
-    if (fstat(lock_fd, &file_stat) == -1) {
-        perror("fstat failed");
-        throw std::runtime_error("Failed to get lock file size");
+void ZeroCopyReadBase::extendMapping(size_t new_size) {
+    size_t needed = roundUpToPage(new_size);
+    if (needed > mapped_size) {
+        if (needed > reserved_size) {
+            growReservation(needed);
+        }
+        size_t old_mapped_size = mapped_size;
+        if (engine_) {
+            mapBuffer(mapped_size, needed - mapped_size);
+            mapped_size = needed;
+            engine_->resize(static_cast<char*>(base_mmap_ptr), mapped_size);
+        } else {
+            // Map only the new tail so pages already faulted in stay mapped.
+            // MAP_SHARED so later appends to the last partial page are visible.
+            void* tail = mmap(static_cast<char*>(base_mmap_ptr) + mapped_size, needed - mapped_size,
+                              PROT_READ, MAP_SHARED | MAP_FIXED | (options_.populate ? MAP_POPULATE : 0),
+                              fd, mapped_size);
+            if (tail == MAP_FAILED) {
+                perror("mmap failed");
+                throw std::runtime_error("Failed to extend mapping");
+            }
+            mapped_size = needed;
+        }
+        adviseMapping(old_mapped_size, mapped_size - old_mapped_size);
     }
-    size_t lock_file_file_size = file_stat.st_size;
+    file_size = new_size;
+}
 
-    if (lock_file_file_size == 0) {
-        return 0; // No data to read
+void ZeroCopyReadBase::mapBuffer(size_t offset, size_t length) {
+    if (length == 0) {
+        return;
+    }
+    if (mmap(static_cast<char*>(base_mmap_ptr) + offset, length, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED) {
+        perror("mmap failed");
+        throw std::runtime_error("Failed to map read buffer");
     }
+    // Every byte of the buffer gets written by a read: huge pages cut the
+    // number of anonymous faults taken while filling it
+    madvise(static_cast<char*>(base_mmap_ptr) + offset, length, MADV_HUGEPAGE);
+}
 
-    lock_mmap_ptr = mmap(nullptr, lock_file_file_size, PROT_READ | PROT_WRITE, MAP_SHARED, lock_fd, 0);
-    size_t char_to_read = lock_file_file_size / sizeof(char);
+void ZeroCopyReadBase::growReservation(size_t needed) {
+    size_t new_reserved = std::max(needed, reserved_size * 2);
+    void* new_base = reserveAddressSpace(new_reserved, options_.huge_pages);
+    if (new_base == MAP_FAILED) {
+        perror("mmap failed");
+        throw std::runtime_error("Failed to grow address space reservation");
+    }
+    if (engine_) {
+        engine_->drain();  // No read may land in the old range
+    }
+    if (mapped_size > 0) {
+        // Move the existing page tables instead of faulting the pages again
+        if (mremap(base_mmap_ptr, mapped_size, mapped_size,
+                   MREMAP_MAYMOVE | MREMAP_FIXED, new_base) == MAP_FAILED) {
+            perror("mremap failed");
+            munmap(new_base, new_reserved);
+            throw std::runtime_error("Failed to move mapping");
+        }
+    }
+    if (reserved_size > mapped_size) {
+        munmap(static_cast<char*>(base_mmap_ptr) + mapped_size, reserved_size - mapped_size);
+    }
+    base_mmap_ptr = new_base;
+    reserved_size = new_reserved;
+    if (engine_) {
+        engine_->resize(static_cast<char*>(base_mmap_ptr), mapped_size);
+    }
+    counters_.remaps.add();
+    iter_mmap_ptr = static_cast<char*>(base_mmap_ptr) + current_position;
+}
 
-    char* str_ptr = static_cast<char*>(lock_mmap_ptr);
+void ZeroCopyReadBase::adviseMapping(size_t offset, size_t length) {
+    size_t page_offset = offset & ~(pageSize() - 1);
+    if (options_.huge_pages
+        && madvise(static_cast<char*>(base_mmap_ptr) + page_offset, offset + length - page_offset,
+                   MADV_HUGEPAGE) == -1) {
+        perror("madvise(MADV_HUGEPAGE) failed");  // THP disabled: keep small pages
+    }
 
-    size_t i = 0;
-    while (i < char_to_read) {
-        char c = str_ptr[i];
-        if (c == '\n') {
+    int advice;
+    switch (options_.access) {
+        case AccessPattern::Sequential:
+            advice = MADV_SEQUENTIAL;
             break;
-        } else if (c == '\0') {
+        case AccessPattern::Random:
+            advice = MADV_RANDOM;
+            break;
+        case AccessPattern::WillNeed: {
+            // Only the part of the new range inside the will-need range
+            size_t begin = std::max(offset, options_.willneed_offset);
+            size_t end = options_.willneed_length == 0
+                ? offset + length
+                : std::min(offset + length, options_.willneed_offset + options_.willneed_length);
+            if (begin >= end) {
+                return;
+            }
+            offset = begin;
+            length = end - begin;
+            advice = MADV_WILLNEED;
             break;
         }
-        buffer[i] = c;
-        i++;
+        default:
+            return;
+    }
+    if (engine_) {
+        // The buffer is anonymous memory: only will-need means anything,
+        // as reads to start now
+        if (advice == MADV_WILLNEED) {
+            engine_->prefetch(offset, offset + length, file_size);
+        }
+        return;
+    }
+    size_t start = offset & ~(pageSize() - 1);
+    if (madvise(static_cast<char*>(base_mmap_ptr) + start, offset + length - start, advice) == -1) {
+        perror("madvise failed");  // Only a hint: keep going without it
     }
-
-    return i;
-
 }
 
-void ZeroCopyRead::readLockfile() {
-    char buffer[MAX_BUFFER_SIZE];  // Make sure this is large enough
-    if (atomicReadLine(buffer) == 0) {
-        return; // No data to read
+void ZeroCopyReadBase::prefetch(size_t offset, size_t length) const {
+    static std::atomic<bool> populate_supported(true);
+    if (offset >= mapped_size || length == 0) {
+        return;
+    }
+    length = std::min(length, mapped_size - offset);
+    if (engine_) {
+        engine_->prefetch(offset, offset + length, file_size);
+        return;
     }
-    std::string read_buffer(buffer);
-    while (std::strcmp(read_buffer.c_str(), file_path_.c_str()) == 0) {
-        // Wait for the lock to be released
-        syncFile(&lock_fd, lock_file_path_.c_str());
-        memset(buffer, 0, sizeof(buffer)); // Clear the buffer
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        if (atomicReadLine(buffer) == 0) {
-            break; // Exit if no data is read
+    size_t start = offset & ~(pageSize() - 1);
+    char* address = static_cast<char*>(base_mmap_ptr) + start;
+    length += offset - start;
+    if (populate_supported.load(std::memory_order_relaxed)) {
+        if (madvise(address, length, MADV_POPULATE_READ) == 0) {
+            return;
+        }
+        if (errno == EINVAL) {
+            populate_supported.store(false, std::memory_order_relaxed);
         }
-        std::string read_buffer(buffer);
     }
-    // Lock is released, we can proceed
+    madvise(address, length, MADV_WILLNEED);
 }
 
-size_t ZeroCopyRead::readData(size_t offset, size_t size, void* buffer) {
-    if (offset + size > file_size) {
-        return 0; // Out of bounds
+size_t ZeroCopyReadBase::getHugePageBytes() const {
+    FILE* smaps = fopen("/proc/self/smaps", "r");
+    if (smaps == nullptr) {
+        return 0;
     }
-
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    
-    memcpy(buffer, static_cast<char*>(base_mmap_ptr) + offset, size);
-    return size;
+    uintptr_t begin = reinterpret_cast<uintptr_t>(base_mmap_ptr);
+    uintptr_t end = begin + mapped_size;
+    bool inside = false;
+    size_t total_kb = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), smaps) != nullptr) {
+        unsigned long vma_start;
+        unsigned long vma_end;
+        char field[64];
+        size_t kb;
+        if (sscanf(line, "%lx-%lx ", &vma_start, &vma_end) == 2) {
+            inside = vma_start < end && vma_end > begin;
+        } else if (inside && sscanf(line, "%63[^:]: %zu kB", field, &kb) == 2) {
+            // PMD-mapped THP of page cache, tmpfs or anonymous memory, or hugetlbfs
+            if (strcmp(field, "FilePmdMapped") == 0 || strcmp(field, "ShmemPmdMapped") == 0
+                || strcmp(field, "AnonHugePages") == 0 || strcmp(field, "Shared_Hugetlb") == 0
+                || strcmp(field, "Private_Hugetlb") == 0) {
+                total_kb += kb;
+            }
+        }
+    }
+    fclose(smaps);
+    return total_kb * 1024;
 }
 
-char ZeroCopyRead::operator*(){
-    //  can not be a constant operator*() because it needs to modify the 
-    // fd if the file is not valid or needs to be synced
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    
-    return *iter_mmap_ptr;
-}
+void ZeroCopyReadBase::remapReplacedFile() {
+    int new_fd = open(file_path_.c_str(), O_RDONLY);
+    if (new_fd == -1) {
+        return; // Between famfs rm and cp: keep serving the old mapping
+    }
+    struct stat file_stat;
+    if (fstat(new_fd, &file_stat) == -1) {
+        close(new_fd);
+        return;
+    }
+    if (engine_) {
+        engine_->drain();
+    }
+    close(fd);
+    fd = new_fd;
+    file_dev = file_stat.st_dev;
+    file_ino = file_stat.st_ino;
 
-size_t ZeroCopyRead::operator++() {
-    if (current_position + 1 >= file_size) {
-        return ERROR_CODE; // End of file reached
+    // Put the reservation back over the old pages, then map the new inode
+    // from the start of the range
+    if (mapped_size > 0) {
+        if (mmap(base_mmap_ptr, mapped_size, PROT_NONE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0) == MAP_FAILED) {
+            perror("mmap failed");
+            throw std::runtime_error("Failed to drop replaced mapping");
+        }
+    }
+    mapped_size = 0;
+    prefetched_until = 0;
+    if (engine_) {
+        engine_->reset(fd);
+    }
+    counters_.remaps.add();
+    // The new file is preallocated past what the writer committed
+    size_t new_size = file_stat.st_size;
+    if (controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+        new_size = std::min(new_size, getCommittedLength());
     }
-    
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    
-    iter_mmap_ptr++;
-    current_position++;
-    return SUCCESS_CODE; // Successfully moved to the next character
+    extendMapping(new_size);
 }
 
-size_t ZeroCopyRead::operator--() {
-    if (current_position == 0) {
-        return ERROR_CODE; // Cannot move back, already at the start
+size_t ZeroCopyReadBase::refresh() {
+    if (sealed_) {
+        return file_size;
+    }
+    if (!options_.follow) {
+        // The mapping is fixed, but more of it may have been committed
+        if (controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+            file_size = std::min(mapped_size, getCommittedLength());
+        }
+        if (sealPublished()) {
+            adoptSeal(getCommittedLength());
+        }
+        return file_size;
     }
 
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    
-    iter_mmap_ptr--;
-    current_position--;
-    return SUCCESS_CODE; // Successfully moved to the previous character
+    counters_.file_checks.add(2);  // stat of the path, fstat of fd
+    struct stat path_stat;
+    if (stat(file_path_.c_str(), &path_stat) == 0
+        && (path_stat.st_ino != file_ino || path_stat.st_dev != file_dev)) {
+        remapReplacedFile();
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1) {
+        perror("fstat failed");
+        throw std::runtime_error("Failed to get file size");
+    }
+    size_t new_size = file_stat.st_size;
+    // Only expose what the writer has committed
+    if (controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+        new_size = std::min(new_size, getCommittedLength());
+    }
+    if (new_size > file_size) {
+        extendMapping(new_size);
+    }
+    if (sealPublished()) {
+        adoptSeal(getCommittedLength());
+    }
+    return file_size;
 }
 
-size_t ZeroCopyRead::operator+=(size_t offset) {
-    if (current_position + offset >= file_size) {
-        return ERROR_CODE; // Out of bounds
+void ZeroCopyReadBase::adoptSeal(std::uint64_t length) {
+    if (options_.follow && length > file_size) {
+        // Sealed since the last refresh: map the tail before going final
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) == -1) {
+            perror("fstat failed");
+            throw std::runtime_error("Failed to get file size");
+        }
+        extendMapping(std::min<size_t>(length, file_stat.st_size));
     }
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
+    file_size = std::min<size_t>(length, options_.follow ? file_size : mapped_size);
+    sealed_ = true;
+}
 
-    iter_mmap_ptr += offset;
-    current_position += offset;
-    return SUCCESS_CODE; // Successfully moved forward by offset
+void ZeroCopyReadBase::detectSeal() {
+    std::uint64_t length;
+    if (readSealMarker(fd, &length)) {
+        adoptSeal(length);
+    } else if (sealPublished()) {
+        adoptSeal(getCommittedLength());
+    }
 }
 
-size_t ZeroCopyRead::operator-=(size_t offset) {
-    if (current_position < offset) {
-        return ERROR_CODE; // Out of bounds
+size_t ZeroCopyReadBase::waitForBytes(size_t offset, int timeout_ms) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    while (options_.follow) {
+        // Taken before refresh(): a commit after it wakes the wait below
+        std::uint32_t seen = control_block->wake_word.load(std::memory_order_seq_cst);
+        if (refresh() >= offset || sealed_) {
+            break;  // Reached, or never will be
+        }
+        int remaining = -1;
+        if (timeout_ms >= 0) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0) {
+                break;
+            }
+            remaining = static_cast<int>(left);
+        }
+        if (controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+            waiter_.waitForCommit(control_block, seen, remaining);
+        } else {
+            // Appended without a coordinating writer: nothing to wake us
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
     }
+    return file_size;
+}
 
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    
-    iter_mmap_ptr -= offset;
-    current_position -= offset;
-    return SUCCESS_CODE; // Successfully moved backward by offset
+void ZeroCopyReadBase::readLockfile() {
+    if (!controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+        return; // No writer is coordinating this file
+    }
+    counters_.lock_checks.add();
+    // An odd sequence means the writer is in the middle of an update
+    if (control_block->sequence.load(std::memory_order_acquire) & 1) {
+        waitForWriter();
+    }
+    // Lock is released, we can proceed
 }
 
-int ZeroCopyRead::operator-(ZeroCopyRead& other) {
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    other.readLockfile();
-    other.syncFile(&other.fd, other.file_path_.c_str());
-    
-    return *reinterpret_cast<int*>(iter_mmap_ptr) - *reinterpret_cast<int*>(other.iter_mmap_ptr);
+void ZeroCopyReadBase::waitForWriter() {
+    auto wait_start = std::chrono::steady_clock::now();
+    waiter_.waitForUnlock(control_block);
+    counters_.lock_wait_ns.add(nanosecondsSince(wait_start));
 }
 
-int ZeroCopyRead::operator+(ZeroCopyRead& other) {
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    other.readLockfile();
-    other.syncFile(&other.fd, other.file_path_.c_str());
-    return *reinterpret_cast<int*>(iter_mmap_ptr) + *reinterpret_cast<int*>(other.iter_mmap_ptr);
+size_t ZeroCopyReadBase::getCommittedLength() {
+    if (!controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+        return file_size;
+    }
+    while (true) {
+        std::uint64_t begin = control_block->sequence.load(std::memory_order_acquire);
+        if (begin & 1) {
+            readLockfile();
+            continue;
+        }
+        std::uint64_t length = control_block->committed_length.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (control_block->sequence.load(std::memory_order_relaxed) == begin) {
+            return length;
+        }
+    }
 }
 
-int ZeroCopyRead::operator*(ZeroCopyRead& other) {
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    other.readLockfile();
-    other.syncFile(&other.fd, other.file_path_.c_str());
-    return *reinterpret_cast<int*>(iter_mmap_ptr) * *reinterpret_cast<int*>(other.iter_mmap_ptr);
+ReadSnapshot ZeroCopyReadBase::snapshot() {
+    ReadSnapshot pinned;
+    pinned.length = refresh();  // Committed bytes that are also mapped
+    pinned.generation = control_block->generation.load(std::memory_order_acquire);
+    snapshot_length = pinned.length;
+    return pinned;
 }
 
-int ZeroCopyRead::operator/( ZeroCopyRead& other) {
-    readLockfile();
-    syncFile(&fd, file_path_.c_str());
-    other.readLockfile();
-    other.syncFile(&other.fd, other.file_path_.c_str());
-    int right_value = *reinterpret_cast<int*>(other.iter_mmap_ptr);
-    if (right_value == 0) {
-        throw std::runtime_error("Division by zero");
-    }
-    return *reinterpret_cast<int*>(iter_mmap_ptr) / right_value;
+ReaderStats ZeroCopyReadBase::stats() const {
+    ReaderStats stats;
+    stats.lock_checks = counters_.lock_checks.load();
+    stats.lock_wait_ns = counters_.lock_wait_ns.load();
+    stats.file_checks = counters_.file_checks.load();
+    stats.remaps = counters_.remaps.load();
+    stats.bytes_served = counters_.bytes_served.load();
+    stats.snapshot_reads = counters_.snapshot_reads.load();
+    std::uint64_t minor_faults;
+    std::uint64_t major_faults;
+    processPageFaults(&minor_faults, &major_faults);
+    stats.minor_faults = minor_faults - opened_minor_faults;
+    stats.major_faults = major_faults - opened_major_faults;
+    return stats;
 }
 
-size_t ZeroCopyRead::getCurrentPosition() const {
+size_t ZeroCopyReadBase::getCurrentPosition() const {
     return current_position;
 }
-size_t ZeroCopyRead::getFileSize() const {
+size_t ZeroCopyReadBase::getFileSize() const {
     return file_size;
 }
-void ZeroCopyRead::resetIterator() {
+void ZeroCopyReadBase::resetIterator() {
     iter_mmap_ptr = static_cast<char*>(base_mmap_ptr);
     current_position = 0;
 }
@@ -17,38 +17,270 @@
 #include <cstring>
 #include <thread>
 #include <chrono>
+#include <string_view>
+#include <algorithm>
+#include <memory>
+
+#include "control-block.h"
+#include "io-uring-engine.h"
+#include "stats.h"
+#include "storage-backend.h"
 
 #define ERROR_CODE 1
 #define SUCCESS_CODE 0
 #define MAX_BUFFER_SIZE 1024
 
-class ZeroCopyRead {
-private:
+// famfs allocation unit (BLOCK_SIZE in write-library.h), which is also the
+// x86-64 PMD huge page size
+static constexpr size_t HUGE_PAGE_SIZE = 2ULL << 20;
+
+// How the mapping is going to be read, passed to the kernel with madvise
+enum class AccessPattern {
+    Normal,      // No hint
+    Sequential,  // MADV_SEQUENTIAL: aggressive readahead, pages dropped behind
+    Random,      // MADV_RANDOM: no readahead
+    WillNeed     // MADV_WILLNEED on [willneed_offset, + willneed_length)
+};
+
+// Options controlling how the data file is mapped
+struct ZeroCopyReadOptions {
+    // Follow the file as the writer appends to it (tail mode). A large
+    // virtual range is reserved up front so the mapping grows in place and
+    // pages already touched are never faulted again.
+    bool follow = false;
+    // Virtual address space reserved in follow mode. If the file outgrows it,
+    // the reservation is moved with mremap and outstanding views are invalid.
+    size_t reserve_size = 1ULL << 30;
+
+    // Access pattern hint for the whole mapping
+    AccessPattern access = AccessPattern::Normal;
+    // AccessPattern::WillNeed range; a length of 0 extends to the end of the file
+    size_t willneed_offset = 0;
+    size_t willneed_length = 0;
+    // Fault in the whole file at construction (MAP_POPULATE), so no page
+    // fault is taken on the read path
+    bool populate = false;
+    // Bytes ahead of the read position that the iterator, the record
+    // iterator and parallelScan populate in one batch. 0 disables it.
+    size_t prefetch_distance = 0;
+    // Place the mapping on 2 MiB boundaries and ask for huge pages
+    // (MADV_HUGEPAGE) so scans of large files take fewer TLB misses. Whether
+    // the backing actually provides them is reported by getHugePageBytes().
+    bool huge_pages = false;
+
+    // How the bytes are read. IoUring reads the file into an anonymous
+    // buffer with io_uring, behind the same view and iterator API; it pays
+    // off where page cache faults are slow (cold data on real block
+    // devices), not on a warm cache. Auto maps files on DAX or in memory and
+    // uses IoUring for files on block filesystems (ext4, xfs, ...), except
+    // followed files, whose tail is hot in the page cache.
+    ReadBackend backend = ReadBackend::Mmap;
+    // Block size, queue depth and readahead of the io_uring backend
+    IoEngineOptions io_engine;
+};
+
+// Committed state pinned by ZeroCopyRead::snapshot()
+struct ReadSnapshot {
+    size_t length = 0;             // Bytes below the watermark
+    std::uint64_t generation = 0;  // Control block generation when it was taken
+};
+
+// Coordination policies of BasicZeroCopyRead: what every access checks
+// before it touches the mapping.
+// No checks: the file is known not to change (sealed, archived, a finished
+// staging copy). The visible length stays what it was when it was opened
+// until refresh() is called explicitly.
+struct NoSync {
+    static constexpr bool coordinated = false;
+    static constexpr bool checks_file = false;
+};
+// Wait out an odd control block sequence: a few atomic loads, no syscall
+struct SeqlockSync {
+    static constexpr bool coordinated = true;
+    static constexpr bool checks_file = false;
+};
+// Seqlock check plus an fstat of the data file, reopening it if it went
+// away. The behaviour of ZeroCopyRead.
+struct LockfileSync {
+    static constexpr bool coordinated = true;
+    static constexpr bool checks_file = true;
+};
+
+// Bounds policies: whether view and readData validate their range. With
+// UncheckedBounds the caller guarantees the range is inside the visible
+// file. The cursor operators always report the end of the file, which is
+// how iteration stops.
+struct CheckedBounds {
+    static constexpr bool checked = true;
+};
+struct UncheckedBounds {
+    static constexpr bool checked = false;
+};
+
+// Statistics policies: whether the inline hot path bumps the reader
+// counters. The out-of-line slow paths (lock waits, remaps, file checks)
+// count either way.
+struct CountedStats {
+    static constexpr bool enabled = true;
+};
+struct NoStats {
+    static constexpr bool enabled = false;
+};
+
+// Mapping, follow mode, backends and writer coordination of a reader; the
+// per-access hot path is in BasicZeroCopyRead
+class ZeroCopyReadBase {
+    // Advances the cursors of several readers under one coordination check
+    friend class ZeroCopyReadSet;
+
+protected:
     int fd;                        // File descriptor (should be an int, not int*)
     int lock_fd;                // File descriptor for the lock file
     size_t file_size;
     size_t current_position;
     void* base_mmap_ptr;
     char* iter_mmap_ptr;
-    void* lock_mmap_ptr;
+    ControlBlock* control_block;   // Shared control block mapped from the lock file
+    bool owns_control_block;       // False when borrowed from a ZeroCopyReadSet
+    dev_t file_dev;                // Identity of the data file, matched against
+    ino_t file_ino;                // the one published in the control block
     std::string file_path_;
     std::string lock_file_path_;
-    
+    ZeroCopyReadOptions options_;
+    size_t mapped_size;            // Page-aligned bytes of the file mapped at base_mmap_ptr
+    size_t reserved_size;          // Bytes of address space owned at base_mmap_ptr
+    size_t prefetched_until;       // End of the range populated by prefetchAhead()
+    size_t snapshot_length;        // Accesses ending at or below it skip coordination
+    bool sealed_;                  // The writer sealed the file: nothing left to coordinate
+    mutable ReaderCounters counters_;
+    ControlBlockWaiter waiter_;    // Blocks on the writer's unlock instead of polling
+    ReadBackend backend_;          // Mmap or IoUring, once resolved
+    std::unique_ptr<IoUringEngine> engine_;  // Fills the buffer for the IoUring backend
+    std::uint64_t opened_minor_faults;  // Process page faults when the reader was opened
+    std::uint64_t opened_major_faults;
+
     alignas(64) char shared_buffer[MAX_BUFFER_SIZE];
     std::atomic<bool> ready;
 
+    // Block until the writer releases the lock, timing the wait
+    void waitForWriter();
+
+    // Whether the writer has sealed the file this reader has open
+    bool sealPublished() const {
+        return controlBlockSealed(control_block) && controlBlockOwnsFile(control_block, file_dev, file_ino);
+    }
+    // The file is final at length: pick up its last bytes and stop coordinating
+    void adoptSeal(std::uint64_t length);
+    // At open: look for the seal marker on the file, then in the control block
+    void detectSeal();
+
+    // IoUring backend: have [offset, end) read into the buffer before it is
+    // accessed. Nothing to do for a mapped file.
+    void loadRange(size_t offset, size_t end) const {
+        if (engine_ && !engine_->loadedUpTo(end)) {
+            engine_->load(offset, end, file_size);
+        }
+    }
+    // Map anonymous memory at [offset, offset + length) of the reservation
+    // for the IoUring backend to read into
+    void mapBuffer(size_t offset, size_t length);
+
+    // Open and map the data file; the control block is already set up
+    void mapDataFile(const char* file_path);
+
+    // Apply the access pattern hint to mapped bytes [offset, offset + length)
+    void adviseMapping(size_t offset, size_t length);
+
+    // Follow mode: map the file up to new_size into the reservation
+    void extendMapping(size_t new_size);
+    // Follow mode: move the mapping into a larger reservation
+    void growReservation(size_t needed);
+    // Follow mode: reopen the path and map the new inode over the old range
+    void remapReplacedFile();
+
 public:
     // Constructor
-    explicit ZeroCopyRead(const char* file_path, const char* lock_file_path);
+    explicit ZeroCopyReadBase(const char* file_path, const char* lock_file_path,
+                              const ZeroCopyReadOptions& options = ZeroCopyReadOptions());
+    // Reader coordinating through a control block owned by the caller (see
+    // ZeroCopyReadSet), which must outlive it
+    ZeroCopyReadBase(const char* file_path, ControlBlock* shared_control_block,
+                     const ZeroCopyReadOptions& options = ZeroCopyReadOptions());
     // Destructor
-    ~ZeroCopyRead();
+    ~ZeroCopyReadBase();
 
-    size_t atomicReadLine(char* buffer);
+    ZeroCopyReadBase(const ZeroCopyReadBase&) = delete;
+    ZeroCopyReadBase& operator=(const ZeroCopyReadBase&) = delete;
 
+    // Block while the writer of this file holds the lock
     void readLockfile();
 
+    // Length of the data file last committed by the writer, read consistently
+    // from the control block. Falls back to the mapped size when no writer
+    // coordinates this file.
+    size_t getCommittedLength();
+
+    // Follow mode: pick up data appended since the last call, and remap if
+    // the file was replaced under the same path. Returns the new file size.
+    // Without follow mode the mapping is fixed, but the visible size still
+    // advances to the committed length published by a mapped writer.
+    size_t refresh();
+
+    // Follow mode: block until at least `offset` bytes are readable, until
+    // timeout_ms elapses (negative waits forever), or until the file is
+    // sealed shorter than that. Returns the file size.
+    size_t waitForBytes(size_t offset, int timeout_ms = -1);
+
+    // Pin the bytes committed so far. The writer only ever appends, so those
+    // bytes cannot change: every later access that ends at or below the
+    // snapshot skips the lock check and the file check, whatever the writer
+    // is doing past it. Taking a new snapshot moves the watermark forward.
+    ReadSnapshot snapshot();
+    // Coordinate every access again
+    void releaseSnapshot() { snapshot_length = 0; }
+    size_t getSnapshotLength() const { return snapshot_length; }
+
+    // Whether the writer sealed the file (WriteLibrary::seal). A sealed
+    // file never changes again: every access skips the lock and file checks
+    // and refresh() returns at once. Detected at open from the marker on
+    // the file, or on the first access or refresh after the seal.
+    bool isSealed() const { return sealed_; }
+    // Whether the reader was opened in follow mode
+    bool isFollowing() const { return options_.follow; }
+
+    // Populate the page tables for [offset, offset + length) in one call
+    // (MADV_POPULATE_READ, or MADV_WILLNEED readahead on older kernels) so
+    // reading the range later takes no page faults. Clamped to the mapping;
+    // safe to call from several threads.
+    void prefetch(size_t offset, size_t length) const;
+
+    // Keep the range [offset, offset + prefetch distance) populated, one batch
+    // per half distance travelled. Does nothing if prefetch_distance is 0.
+    void prefetchAhead(size_t offset) {
+        if (options_.prefetch_distance != 0 && offset + options_.prefetch_distance / 2 >= prefetched_until) {
+            size_t start = std::max(offset, prefetched_until);
+            prefetch(start, offset + options_.prefetch_distance - start);
+            prefetched_until = offset + options_.prefetch_distance;
+        }
+    }
+
+    size_t getPrefetchDistance() const { return options_.prefetch_distance; }
+
+    // Backend in use, never Auto
+    ReadBackend getBackend() const { return backend_; }
+    // The io_uring engine behind the IoUring backend, nullptr when mapped
+    const IoUringEngine* getIoEngine() const { return engine_.get(); }
+
+    // Snapshot of the hot-path counters (stats.h)
+    ReaderStats stats() const;
+
+    // Bytes of the mapping currently backed by huge pages, from
+    // /proc/self/smaps. 0 if none were obtained or smaps is unavailable.
+    size_t getHugePageBytes() const;
+
     size_t checkFileValidity(int fd) const {
         struct stat file_stat;
+        counters_.file_checks.add();
         if (fstat(fd, &file_stat) == -1) {
             return ERROR_CODE; // Failed to get file status
         }
@@ -82,27 +314,231 @@ public:
         return SUCCESS_CODE;
     }
 
+    size_t getCurrentPosition() const;
+    size_t getFileSize() const;
+    void resetIterator();
+};
+
+// Reader whose per-access checks are chosen at compile time. Everything on
+// the access path is inline, and what a policy turns off is compiled out:
+//
+//     BasicZeroCopyRead<NoSync, UncheckedBounds, NoStats> archive(path, lock_path);
+//     std::string_view bytes = archive.view(0, archive.getFileSize());  // No checks at all
+//
+// ZeroCopyRead is BasicZeroCopyRead<LockfileSync, CheckedBounds, CountedStats>.
+// Snapshots and seals skip coordination under any coordinated policy.
+template <typename Sync, typename Bounds, typename Stats>
+class BasicZeroCopyRead : public ZeroCopyReadBase {
+private:
+    // Wait for the writer to release the lock and make sure fd is still valid,
+    // before reading bytes up to end. Skipped below the snapshot.
+    void checkCoordination(size_t end) {
+        if constexpr (Sync::coordinated) {
+            if (sealed_) {
+                return; // Final: nothing left to coordinate
+            }
+            if (end <= snapshot_length) {
+                if constexpr (Stats::enabled) {
+                    counters_.snapshot_reads.add();
+                }
+                return; // Committed before the snapshot: the writer cannot touch it
+            }
+            if constexpr (Sync::checks_file) {
+                readLockfile();
+                syncFile(&fd, file_path_.c_str());
+            } else if (controlBlockOwnsFile(control_block, file_dev, file_ino)) {
+                if constexpr (Stats::enabled) {
+                    counters_.lock_checks.add();
+                }
+                // An odd sequence means the writer is in the middle of an update
+                if (control_block->sequence.load(std::memory_order_acquire) & 1) {
+                    waitForWriter();
+                }
+            }
+            if (sealPublished()) {
+                adoptSeal(getCommittedLength());
+            }
+        } else {
+            (void)end;
+        }
+    }
+
+    // Visible size after picking up appended bytes, if the policy looks for them
+    size_t refreshedSize() {
+        if constexpr (Sync::coordinated) {
+            return refresh();
+        } else {
+            return file_size;
+        }
+    }
+
+    void countBytes(size_t size) const {
+        if constexpr (Stats::enabled) {
+            counters_.bytes_served.add(size);
+        } else {
+            (void)size;
+        }
+    }
+
+    // The int at the cursor, read without alignment or end-of-file faults
+    int loadInt() const {
+        // memcpy avoids the unaligned load, and near the end of the file only the
+        // bytes that exist are read (the rest stay zero)
+        int value = 0;
+        countBytes(sizeof(int));
+        size_t available = current_position < file_size ? file_size - current_position : 0;
+        size_t length = available < sizeof(int) ? available : sizeof(int);
+        loadRange(current_position, current_position + length);
+        memcpy(&value, iter_mmap_ptr, length);
+        return value;
+    }
+
+public:
+    using ZeroCopyReadBase::ZeroCopyReadBase;
+
     // Fill the buffer with data from the file from the specified offset
     // to the specified size.
-    size_t readData(size_t offset, size_t size, void* buffer);
+    size_t readData(size_t offset, size_t size, void* buffer) {
+        if constexpr (Bounds::checked) {
+            if (offset + size > file_size) {
+                return 0; // Out of bounds
+            }
+        }
 
-    char operator*();
+        checkCoordination(offset + size);
+        loadRange(offset, offset + size);
+        countBytes(size);
 
-    size_t operator++();
-    size_t operator--();
+        memcpy(buffer, static_cast<char*>(base_mmap_ptr) + offset, size);
+        return size;
+    }
 
-    size_t operator+=(size_t offset);
-    size_t operator-=(size_t offset);
+    // Return a view of [offset, offset + size) directly into the mapping,
+    // without copying. Coordination with the writer is checked once for the
+    // whole range instead of once per byte. An empty view is returned if the
+    // range is out of bounds.
+    // The view stays valid until the reader is destroyed. It reflects the
+    // bytes committed at the time of the call; data appended afterwards needs
+    // a new call to view().
+    std::string_view view(size_t offset, size_t size) {
+        if constexpr (Bounds::checked) {
+            if (offset > file_size || size > file_size - offset) {
+                // In follow mode the range may have been appended since the last refresh
+                refreshedSize();
+                if (offset > file_size || size > file_size - offset) {
+                    return std::string_view(); // Out of bounds
+                }
+            }
+        }
 
-    int operator-(ZeroCopyRead& other);
-    int operator+(ZeroCopyRead& other);
+        // One coordination check covers the whole range
+        checkCoordination(offset + size);
+        loadRange(offset, offset + size);
+        countBytes(size);
 
-    int operator*(ZeroCopyRead& other);
-    int operator/(ZeroCopyRead& other);
+        return std::string_view(static_cast<const char*>(base_mmap_ptr) + offset, size);
+    }
 
-    size_t getCurrentPosition() const;
-    size_t getFileSize() const;
-    void resetIterator();
+    char operator*() {
+        //  can not be a constant operator*() because it needs to modify the
+        // fd if the file is not valid or needs to be synced
+        checkCoordination(current_position + 1);
+        loadRange(current_position, current_position + 1);
+        countBytes(1);
+
+        return *iter_mmap_ptr;
+    }
+
+    size_t operator++() {
+        if (current_position + 1 >= file_size && current_position + 1 >= refreshedSize()) {
+            return ERROR_CODE; // End of file reached
+        }
+
+        checkCoordination(current_position + 2);
+
+        iter_mmap_ptr++;
+        current_position++;
+        prefetchAhead(current_position);
+        return SUCCESS_CODE; // Successfully moved to the next character
+    }
+
+    size_t operator--() {
+        if (current_position == 0) {
+            return ERROR_CODE; // Cannot move back, already at the start
+        }
+
+        checkCoordination(current_position);
+
+        iter_mmap_ptr--;
+        current_position--;
+        return SUCCESS_CODE; // Successfully moved to the previous character
+    }
+
+    size_t operator+=(size_t offset) {
+        if (current_position + offset >= file_size && current_position + offset >= refreshedSize()) {
+            return ERROR_CODE; // Out of bounds
+        }
+        checkCoordination(current_position + offset + 1);
+
+        iter_mmap_ptr += offset;
+        current_position += offset;
+        prefetchAhead(current_position);
+        return SUCCESS_CODE; // Successfully moved forward by offset
+    }
+
+    size_t operator-=(size_t offset) {
+        if (current_position < offset) {
+            return ERROR_CODE; // Out of bounds
+        }
+
+        checkCoordination(current_position - offset + 1);
+
+        iter_mmap_ptr -= offset;
+        current_position -= offset;
+        return SUCCESS_CODE; // Successfully moved backward by offset
+    }
+
+    // Combine the ints at both cursors. Prefer TypedView (typed-view.h) for
+    // numeric data: these read an int at every byte position.
+    int operator-(BasicZeroCopyRead& other) {
+        checkCoordination(current_position + sizeof(int));
+        other.checkCoordination(other.current_position + sizeof(int));
+        return loadInt() - other.loadInt();
+    }
+
+    int operator+(BasicZeroCopyRead& other) {
+        checkCoordination(current_position + sizeof(int));
+        other.checkCoordination(other.current_position + sizeof(int));
+        return loadInt() + other.loadInt();
+    }
+
+    int operator*(BasicZeroCopyRead& other) {
+        checkCoordination(current_position + sizeof(int));
+        other.checkCoordination(other.current_position + sizeof(int));
+        return loadInt() * other.loadInt();
+    }
+
+    int operator/(BasicZeroCopyRead& other) {
+        checkCoordination(current_position + sizeof(int));
+        other.checkCoordination(other.current_position + sizeof(int));
+        int right_value = other.loadInt();
+        if (right_value == 0) {
+            throw std::runtime_error("Division by zero");
+        }
+        return loadInt() / right_value;
+    }
 };
 
+// The coordinated reader the rest of the library (line index, record
+// iterator, typed views, parallel scan, zip kernels, read sets) works on
+class ZeroCopyRead : public BasicZeroCopyRead<LockfileSync, CheckedBounds, CountedStats> {
+public:
+    using BasicZeroCopyRead::BasicZeroCopyRead;
+};
+
+// A file that no longer changes, read without any check
+using ImmutableZeroCopyRead = BasicZeroCopyRead<NoSync, UncheckedBounds, NoStats>;
+// A coordinated file read without the per-access fstat
+using SeqlockZeroCopyRead = BasicZeroCopyRead<SeqlockSync, CheckedBounds, CountedStats>;
+
 #endif // ZERO_COPY_READ_LIBRARY_H
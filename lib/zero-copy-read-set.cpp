@@ -0,0 +1,145 @@
+#include "zero-copy-read-set.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+ZeroCopyReadSet::ZeroCopyReadSet(const std::vector<std::string>& file_paths, const char* lock_file_path,
+                                 const ZeroCopyReadOptions& options)
+    : position(0), length(0), seen_generation(0), seen_magic(false), writer_owns_stream(false),
+      snapshot_length(0) {
+    if (file_paths.empty()) {
+        throw std::runtime_error("ZeroCopyReadSet needs at least one file");
+    }
+    lock_fd = open(lock_file_path, O_RDWR);
+    if (lock_fd == -1) {
+        perror("Failed to open lock file");
+        throw std::runtime_error("Failed to open lock file");
+    }
+    control_block = mapControlBlock(lock_fd);
+    waiter_.watchLockFile(lock_fd);
+
+    try {
+        for (const std::string& path : file_paths) {
+            streams.push_back(std::make_unique<ZeroCopyRead>(path.c_str(), control_block, options));
+            streams.back()->waiter_.watchLockFile(lock_fd);
+        }
+    } catch (...) {
+        streams.clear();
+        unmapControlBlock(control_block);
+        close(lock_fd);
+        throw;
+    }
+    syncStreams();
+}
+
+ZeroCopyReadSet::~ZeroCopyReadSet() {
+    streams.clear();  // The streams borrow the control block
+    unmapControlBlock(control_block);
+    close(lock_fd);
+}
+
+void ZeroCopyReadSet::syncStreams() {
+    seen_magic = control_block->magic.load(std::memory_order_acquire) == CONTROL_BLOCK_MAGIC;
+    seen_generation = control_block->generation.load(std::memory_order_acquire);
+    writer_owns_stream = false;
+    length = SIZE_MAX;
+    for (auto& stream : streams) {
+        stream->syncFile(&stream->fd, stream->file_path_.c_str());
+        length = std::min(length, stream->refresh());
+        writer_owns_stream = writer_owns_stream
+            || controlBlockOwnsFile(control_block, stream->file_dev, stream->file_ino);
+    }
+}
+
+void ZeroCopyReadSet::checkCoordination(size_t end) {
+    if (end <= snapshot_length) {
+        counters_.snapshot_reads.add();
+        return; // Committed in every stream before the snapshot
+    }
+    bool magic = control_block->magic.load(std::memory_order_acquire) == CONTROL_BLOCK_MAGIC;
+    if (magic != seen_magic
+        || (magic && control_block->generation.load(std::memory_order_acquire) != seen_generation)) {
+        syncStreams();
+    }
+    if (!writer_owns_stream) {
+        return; // No writer is coordinating any of the files
+    }
+    counters_.lock_checks.add();
+    // An odd sequence means the writer is in the middle of an update
+    if (control_block->sequence.load(std::memory_order_acquire) & 1) {
+        auto wait_start = std::chrono::steady_clock::now();
+        waiter_.waitForUnlock(control_block);
+        counters_.lock_wait_ns.add(nanosecondsSince(wait_start));
+    }
+}
+
+size_t ZeroCopyReadSet::refresh() {
+    length = SIZE_MAX;
+    for (auto& stream : streams) {
+        length = std::min(length, stream->refresh());
+    }
+    return length;
+}
+
+ReadSnapshot ZeroCopyReadSet::snapshot() {
+    checkCoordination(SIZE_MAX);  // Resync the streams if the writer replaced one
+    ReadSnapshot pinned;
+    pinned.length = refresh();
+    pinned.generation = control_block->generation.load(std::memory_order_acquire);
+    snapshot_length = pinned.length;
+    return pinned;
+}
+
+size_t ZeroCopyReadSet::operator++() {
+    if (position + 1 >= length && position + 1 >= refresh()) {
+        return ERROR_CODE; // End of the shortest stream
+    }
+    checkCoordination(position + 2);
+    position++;
+    return SUCCESS_CODE;
+}
+
+size_t ZeroCopyReadSet::operator+=(size_t offset) {
+    if (position + offset >= length && position + offset >= refresh()) {
+        return ERROR_CODE; // Out of bounds
+    }
+    checkCoordination(position + offset + 1);
+    position += offset;
+    return SUCCESS_CODE;
+}
+
+bool ZeroCopyReadSet::views(size_t offset, size_t size, std::string_view* out) {
+    if (offset > length || size > length - offset) {
+        refresh();
+        if (offset > length || size > length - offset) {
+            return false;
+        }
+    }
+    // One coordination check covers the range in every stream
+    checkCoordination(offset + size);
+    for (size_t i = 0; i < streams.size(); ++i) {
+        streams[i]->loadRange(offset, offset + size);
+        out[i] = std::string_view(static_cast<const char*>(streams[i]->base_mmap_ptr) + offset, size);
+    }
+    counters_.bytes_served.add(size * streams.size());
+    return true;
+}
+
+ReaderStats ZeroCopyReadSet::stats() const {
+    ReaderStats total = streams[0]->stats();  // Page faults are process-wide
+    for (size_t i = 1; i < streams.size(); ++i) {
+        ReaderStats stream = streams[i]->stats();
+        total.lock_checks += stream.lock_checks;
+        total.lock_wait_ns += stream.lock_wait_ns;
+        total.file_checks += stream.file_checks;
+        total.remaps += stream.remaps;
+        total.bytes_served += stream.bytes_served;
+        total.snapshot_reads += stream.snapshot_reads;
+    }
+    total.lock_checks += counters_.lock_checks.load();
+    total.lock_wait_ns += counters_.lock_wait_ns.load();
+    total.bytes_served += counters_.bytes_served.load();
+    total.snapshot_reads += counters_.snapshot_reads.load();
+    return total;
+}
@@ -0,0 +1,106 @@
+#ifndef ZERO_COPY_READ_SET_H
+#define ZERO_COPY_READ_SET_H
+
+/*
+    * Zero Copy Read Set
+    * N data files (columns) read in lockstep under one lock file. The
+    * control block is mapped once for the whole set, and every step of the
+    * shared cursor or multi-stream view costs a single coordination check,
+    * however many files the set holds.
+    *
+    * Replacement of a data file (the famfs growth path) is detected through
+    * the control block generation, so the per-file fstat of ZeroCopyRead is
+    * only paid when the generation changes, not on every step.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "control-block.h"
+#include "zero-copy-read-library.h"
+
+class ZeroCopyReadSet {
+    private:
+        int lock_fd;
+        ControlBlock* control_block;
+        std::vector<std::unique_ptr<ZeroCopyRead>> streams;
+        size_t position;             // Shared cursor, the same offset in every stream
+        size_t length;               // Size of the shortest stream
+        std::uint64_t seen_generation;
+        bool seen_magic;
+        bool writer_owns_stream;     // The control block coordinates one of the streams
+        size_t snapshot_length;      // Steps and views ending at or below it skip coordination
+        mutable ReaderCounters counters_;  // Coordination and bytes of the set itself
+        ControlBlockWaiter waiter_;
+
+        // Wait for the writer once for all streams, resyncing them if the
+        // writer published a new file since the last step. Skipped for
+        // accesses ending at or below the snapshot.
+        void checkCoordination(size_t end);
+        // Refresh every stream and recompute the aligned length
+        void syncStreams();
+
+    public:
+        ZeroCopyReadSet(const std::vector<std::string>& file_paths, const char* lock_file_path,
+                        const ZeroCopyReadOptions& options = ZeroCopyReadOptions());
+        ~ZeroCopyReadSet();
+
+        ZeroCopyReadSet(const ZeroCopyReadSet&) = delete;
+        ZeroCopyReadSet& operator=(const ZeroCopyReadSet&) = delete;
+
+        size_t streamCount() const { return streams.size(); }
+        ZeroCopyRead& stream(size_t i) { return *streams[i]; }
+
+        // Bytes readable in every stream
+        size_t getLength() const { return length; }
+        // Pick up data committed since the last call; returns the new length
+        size_t refresh();
+
+        // Pin the bytes committed in every stream, as ZeroCopyRead::snapshot()
+        // does for one file
+        ReadSnapshot snapshot();
+        void releaseSnapshot() { snapshot_length = 0; }
+
+        // Move every cursor together. Return ERROR_CODE at the end of the
+        // shortest stream, as the ZeroCopyRead operators do.
+        size_t operator++();
+        size_t operator+=(size_t offset);
+        size_t getCurrentPosition() const { return position; }
+        void resetIterators() { position = 0; }
+
+        // Byte at the shared cursor in stream i
+        char current(size_t i) const {
+            counters_.bytes_served.add(1);
+            streams[i]->loadRange(position, position + 1);
+            return static_cast<const char*>(streams[i]->base_mmap_ptr)[position];
+        }
+
+        // T at the shared cursor in stream i. Bytes past the end of the
+        // stream read as zero.
+        template <typename T>
+        T value(size_t i) const {
+            T result{};
+            counters_.bytes_served.add(sizeof(T));
+            size_t available = streams[i]->file_size > position ? streams[i]->file_size - position : 0;
+            streams[i]->loadRange(position, position + std::min(available, sizeof(T)));
+            memcpy(&result, static_cast<const char*>(streams[i]->base_mmap_ptr) + position,
+                   available < sizeof(T) ? available : sizeof(T));
+            return result;
+        }
+
+        // Fill out[0, streamCount()) with the view of [offset, offset + size)
+        // of every stream, under one coordination check. Returns false, and
+        // leaves out untouched, if the range is past the shortest stream.
+        bool views(size_t offset, size_t size, std::string_view* out);
+
+        // Counters of the set's own coordination and accesses, plus those of
+        // the streams accessed directly
+        ReaderStats stats() const;
+};
+
+#endif // ZERO_COPY_READ_SET_H
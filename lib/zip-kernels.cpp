@@ -0,0 +1,114 @@
+#include "zip-kernels.h"
+
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+// Integer sums and products are taken in uint64_t, where overflow wraps
+// instead of being undefined, and handed back as two's complement int64_t
+template <typename T>
+using ZipWrapping = typename std::conditional<std::is_floating_point<T>::value, double, std::uint64_t>::type;
+
+// Inner loop of one block of a built-in reduction. Always inlined, so each
+// target-specific wrapper below compiles it for its own ISA. The simd
+// pragmas let the floating point sums be reassociated into vector lanes.
+template <typename T, ZipOp Op>
+__attribute__((always_inline)) static inline ZipAccumulator<T>
+reduceBlock(const char* a, const char* b, size_t count, ZipAccumulator<T> acc) {
+    using Wide = ZipWrapping<T>;
+    if constexpr (Op == ZipOp::Sum) {
+        Wide sum = static_cast<Wide>(acc);
+        #pragma omp simd reduction(+:sum)
+        for (size_t i = 0; i < count; ++i) {
+            T x, y;
+            memcpy(&x, a + i * sizeof(T), sizeof(T));
+            memcpy(&y, b + i * sizeof(T), sizeof(T));
+            sum += static_cast<Wide>(x) + static_cast<Wide>(y);
+        }
+        acc = static_cast<ZipAccumulator<T>>(sum);
+    } else if constexpr (Op == ZipOp::Dot) {
+        Wide sum = static_cast<Wide>(acc);
+        #pragma omp simd reduction(+:sum)
+        for (size_t i = 0; i < count; ++i) {
+            T x, y;
+            memcpy(&x, a + i * sizeof(T), sizeof(T));
+            memcpy(&y, b + i * sizeof(T), sizeof(T));
+            sum += static_cast<Wide>(x) * static_cast<Wide>(y);
+        }
+        acc = static_cast<ZipAccumulator<T>>(sum);
+    } else if constexpr (Op == ZipOp::Min) {
+        T lowest = static_cast<T>(acc);
+        #pragma omp simd reduction(min:lowest)
+        for (size_t i = 0; i < count; ++i) {
+            T x, y;
+            memcpy(&x, a + i * sizeof(T), sizeof(T));
+            memcpy(&y, b + i * sizeof(T), sizeof(T));
+            lowest = std::min(lowest, std::min(x, y));
+        }
+        acc = lowest;
+    } else {
+        T highest = static_cast<T>(acc);
+        #pragma omp simd reduction(max:highest)
+        for (size_t i = 0; i < count; ++i) {
+            T x, y;
+            memcpy(&x, a + i * sizeof(T), sizeof(T));
+            memcpy(&y, b + i * sizeof(T), sizeof(T));
+            highest = std::max(highest, std::max(x, y));
+        }
+        acc = highest;
+    }
+    return acc;
+}
+
+template <typename T, ZipOp Op>
+__attribute__((target("avx2")))
+static ZipAccumulator<T> reduceBlockAvx2(const char* a, const char* b, size_t count, ZipAccumulator<T> acc) {
+    return reduceBlock<T, Op>(a, b, count, acc);
+}
+
+template <typename T, ZipOp Op>
+static ZipAccumulator<T> reduceBlockDefault(const char* a, const char* b, size_t count, ZipAccumulator<T> acc) {
+    return reduceBlock<T, Op>(a, b, count, acc);
+}
+
+template <typename T, ZipOp Op>
+static ZipAccumulator<T> reduceFiles(ZeroCopyRead& a, ZeroCopyRead& b) {
+    static const bool use_avx2 = __builtin_cpu_supports("avx2");
+    using Acc = ZipAccumulator<T>;
+
+    size_t count = zipElementCount<T>(a, b);
+    Acc acc = 0;
+    if (Op == ZipOp::Min && count > 0) {
+        acc = std::numeric_limits<T>::max();
+    } else if (Op == ZipOp::Max && count > 0) {
+        acc = std::numeric_limits<T>::lowest();
+    }
+    for (size_t start = 0; start < count; start += ZIP_BLOCK_ELEMENTS) {
+        size_t block = std::min(ZIP_BLOCK_ELEMENTS, count - start);
+        // One coordination check per file for the whole block
+        const char* a_block = a.view(start * sizeof(T), block * sizeof(T)).data();
+        const char* b_block = b.view(start * sizeof(T), block * sizeof(T)).data();
+        if (a_block == nullptr || b_block == nullptr) {
+            throw std::runtime_error("zipReduce block is past the end of the file");
+        }
+        acc = use_avx2 ? reduceBlockAvx2<T, Op>(a_block, b_block, block, acc)
+                       : reduceBlockDefault<T, Op>(a_block, b_block, block, acc);
+    }
+    return acc;
+}
+
+template <typename T>
+ZipAccumulator<T> zipReduce(ZeroCopyRead& a, ZeroCopyRead& b, ZipOp op) {
+    switch (op) {
+        case ZipOp::Sum: return reduceFiles<T, ZipOp::Sum>(a, b);
+        case ZipOp::Min: return reduceFiles<T, ZipOp::Min>(a, b);
+        case ZipOp::Max: return reduceFiles<T, ZipOp::Max>(a, b);
+        case ZipOp::Dot: return reduceFiles<T, ZipOp::Dot>(a, b);
+    }
+    throw std::runtime_error("Unknown zip operation");
+}
+
+template ZipAccumulator<int32_t> zipReduce<int32_t>(ZeroCopyRead&, ZeroCopyRead&, ZipOp);
+template ZipAccumulator<int64_t> zipReduce<int64_t>(ZeroCopyRead&, ZeroCopyRead&, ZipOp);
+template ZipAccumulator<float> zipReduce<float>(ZeroCopyRead&, ZeroCopyRead&, ZipOp);
+template ZipAccumulator<double> zipReduce<double>(ZeroCopyRead&, ZeroCopyRead&, ZipOp);
@@ -0,0 +1,91 @@
+#ifndef ZIP_KERNELS_H
+#define ZIP_KERNELS_H
+
+/*
+    * Zip Kernels
+    * Walk two or more ZeroCopyRead files in lockstep, interpreting each as a
+    * packed array of T, and combine their elements. The files are processed
+    * in blocks of ZIP_BLOCK_ELEMENTS: each block costs one coordination check
+    * per file, and the inner loop over the block is a plain array loop.
+    *
+    * The built-in reductions (sum, min, max, dot) over two files are compiled
+    * with SIMD inner loops, selected at runtime (AVX2 or the baseline ISA).
+    * zipReduce/zipTransform with custom functors are templates, vectorized by
+    * the compiler of the calling code where it can.
+*/
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "typed-view.h"
+#include "zero-copy-read-library.h"
+
+static constexpr size_t ZIP_BLOCK_ELEMENTS = 1 << 16;
+
+enum class ZipOp {
+    Sum,  // sum of a[i] + b[i]
+    Min,  // smallest of all a[i] and b[i]
+    Max,  // largest of all a[i] and b[i]
+    Dot   // sum of a[i] * b[i]
+};
+
+// Accumulator used by the built-in reductions: int64_t for integers, double
+// for floating point. Integer Sum and Dot are computed in uint64_t and wrap
+// modulo 2^64 (two's complement) where the exact result does not fit,
+// instead of overflowing
+template <typename T>
+using ZipAccumulator = typename std::conditional<std::is_floating_point<T>::value, double, std::int64_t>::type;
+
+// Built-in reduction of a and b interpreted as arrays of T, over as many
+// whole elements as both files hold. Implemented for int32_t, int64_t,
+// float and double. Min/Max of two empty files return 0.
+template <typename T>
+ZipAccumulator<T> zipReduce(ZeroCopyRead& a, ZeroCopyRead& b, ZipOp op);
+
+// Number of whole T elements every reader holds
+template <typename T, typename... Readers>
+size_t zipElementCount(ZeroCopyRead& first, Readers&... rest) {
+    size_t count = first.getFileSize() / sizeof(T);
+    ((count = std::min(count, rest.getFileSize() / sizeof(T))), ...);
+    return count;
+}
+
+// acc = reduce(acc, combine(first[i], rest[i]...)) for every element index
+template <typename T, typename Acc, typename Combine, typename Reduce, typename... Readers>
+Acc zipReduce(Acc init, Combine combine, Reduce reduce, ZeroCopyRead& first, Readers&... rest) {
+    size_t count = zipElementCount<T>(first, rest...);
+    Acc acc = init;
+    for (size_t start = 0; start < count; start += ZIP_BLOCK_ELEMENTS) {
+        size_t block = std::min(ZIP_BLOCK_ELEMENTS, count - start);
+        TypedView<T> first_block(first, start * sizeof(T), block);
+        auto run = [&](const auto&... rest_blocks) {
+            for (size_t i = 0; i < block; ++i) {
+                acc = reduce(acc, combine(first_block[i], rest_blocks[i]...));
+            }
+        };
+        run(TypedView<T>(rest, start * sizeof(T), block)...);
+    }
+    return acc;
+}
+
+// *out++ = fn(first[i], rest[i]...) for every element index. Returns the
+// output iterator past the last element written.
+template <typename T, typename OutputIt, typename Fn, typename... Readers>
+OutputIt zipTransform(OutputIt out, Fn fn, ZeroCopyRead& first, Readers&... rest) {
+    size_t count = zipElementCount<T>(first, rest...);
+    for (size_t start = 0; start < count; start += ZIP_BLOCK_ELEMENTS) {
+        size_t block = std::min(ZIP_BLOCK_ELEMENTS, count - start);
+        TypedView<T> first_block(first, start * sizeof(T), block);
+        auto run = [&](const auto&... rest_blocks) {
+            for (size_t i = 0; i < block; ++i) {
+                *out++ = fn(first_block[i], rest_blocks[i]...);
+            }
+        };
+        run(TypedView<T>(rest, start * sizeof(T), block)...);
+    }
+    return out;
+}
+
+#endif // ZIP_KERNELS_H
@@ -0,0 +1,237 @@
+// test_column_format.cpp
+// Converts generated integer text into column files and checks every value
+// against strtoll: numbers of every length, signs, odd separators, values at
+// the int64 limits, narrowing errors, ColumnView's header checks, uint64
+// values above INT64_MAX, and replacing a column that is still mapped.
+
+#include "column-convert.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+static bool writeFile(const std::string& path, const std::string& contents) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << contents;
+    return static_cast<bool>(out);
+}
+
+// Values of text the plain way: a digit run, negative after a '-'
+static std::vector<std::int64_t> referenceParse(const std::string& text) {
+    std::vector<std::int64_t> values;
+    const char* p = text.c_str();
+    const char* end = p + text.size();
+    while (p < end) {
+        if (*p >= '0' && *p <= '9') {
+            bool negative = p > text.c_str() && p[-1] == '-';
+            char* next;
+            values.push_back(std::strtoll(negative ? p - 1 : p, &next, 10));
+            p = next;
+        } else {
+            ++p;
+        }
+    }
+    return values;
+}
+
+// Convert text, then read the column back through ColumnView<T>
+template <typename T>
+static bool roundTrip(const std::string& label, const std::string& text, const std::string& dir,
+                      const std::string& lock_path, ColumnConvertOptions options) {
+    const std::string text_path = dir + ".txt";
+    const std::string column_path = dir + ".col";
+    writeFile(text_path, text);
+    ZeroCopyRead reader(text_path.c_str(), lock_path.c_str());
+    options.type = ColumnTypeOf<T>::value;
+    ColumnConvertResult result = convertToColumn(reader, column_path.c_str(), options);
+
+    ZeroCopyRead column_reader(column_path.c_str(), lock_path.c_str());
+    ColumnView<T> column(column_reader);
+    std::vector<std::int64_t> expected = referenceParse(text);
+    bool matches = column.size() == expected.size() && result.count == expected.size();
+    for (size_t i = 0; matches && i < expected.size(); ++i) {
+        matches = static_cast<std::int64_t>(column[i]) == expected[i];
+    }
+    bool aligned = column.alignedData() != nullptr && column.header().data_offset % options.alignment == 0;
+    std::cout << "[" << label << "] " << result.count << " " << columnTypeName(options.type) << " values from "
+              << result.text_bytes << " bytes, match strtoll = " << matches << ", aligned = " << aligned << "\n";
+    unlink(text_path.c_str());
+    unlink(column_path.c_str());
+    return matches && aligned;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <scratch_prefix>\n";
+        return 1;
+    }
+    const std::string prefix = argv[1];
+    const std::string lock_path = prefix + ".lock";
+    bool ok = true;
+    std::cout << "integer parse implementation: " << integerParseImplementation() << "\n\n";
+    {
+        int lf = open(lock_path.c_str(), O_CREAT | O_RDWR, 0666);
+        if (lf < 0 || ftruncate(lf, 1) != 0) {
+            std::cerr << "lock file: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+        close(lf);
+    }
+
+    try {
+        // 1) Every length from 1 to 19 digits, both signs, mixed separators,
+        //    and a last value with no newline after it
+        {
+            std::mt19937_64 rng(7);
+            std::string text;
+            const char* separators[] = { "\n", " ", ",", "\t", ", ", " ;\r\n" };
+            for (int i = 0; i < 200000; ++i) {
+                int digits = 1 + i % 19;
+                std::uint64_t limit = 1;
+                for (int d = 0; d < digits && d < 18; ++d) {
+                    limit *= 10;
+                }
+                std::uint64_t value = rng() % limit;
+                if (digits == 19) {
+                    value = rng() % 9223372036854775807ULL;
+                }
+                if (i % 3 == 0) {
+                    text += '-';
+                }
+                text += std::to_string(value);
+                text += separators[i % 6];
+            }
+            text += "9223372036854775807 -9223372036854775808 0 -0 007";
+            ColumnConvertOptions options;
+            options.chunk_size = 64 * 1024;  // Many chunks, several per worker
+            options.threads = 4;
+            ok = roundTrip<std::int64_t>("int64 lengths", text, prefix + "-a", lock_path, options) && ok;
+        }
+
+        // 2) int32 column, 4 KiB-aligned data
+        {
+            std::string text;
+            for (std::int64_t i = -100000; i < 100000; i += 7) {
+                text += std::to_string(i * 10007) + "\n";
+            }
+            ColumnConvertOptions options;
+            options.alignment = 4096;
+            ok = roundTrip<std::int32_t>("int32", text, prefix + "-b", lock_path, options) && ok;
+            ok = roundTrip<std::uint32_t>("uint32", "0\n4294967295\n17\n", prefix + "-c", lock_path,
+                                          ColumnConvertOptions()) && ok;
+        }
+
+        // 3) Values that do not fit are refused, and no column is left behind
+        {
+            const std::string text_path = prefix + "-d.txt";
+            const std::string column_path = prefix + "-d.col";
+            bool int32_refused = false;
+            bool int64_refused = false;
+            writeFile(text_path, "1\n2147483648\n3\n");
+            {
+                ZeroCopyRead reader(text_path.c_str(), lock_path.c_str());
+                ColumnConvertOptions options;
+                options.type = ColumnType::Int32;
+                try {
+                    convertToColumn(reader, column_path.c_str(), options);
+                } catch (const std::runtime_error&) {
+                    int32_refused = access(column_path.c_str(), F_OK) != 0;
+                }
+            }
+            writeFile(text_path, "1\n9223372036854775808\n");
+            {
+                ZeroCopyRead reader(text_path.c_str(), lock_path.c_str());
+                try {
+                    convertToColumn(reader, column_path.c_str());
+                } catch (const std::runtime_error&) {
+                    int64_refused = true;
+                }
+            }
+            std::cout << "[range] 2^31 refused for int32 = " << int32_refused << ", 2^63 refused for int64 = "
+                      << int64_refused << "\n";
+            ok = ok && int32_refused && int64_refused;
+
+            // 4) ColumnView checks the header against its element type
+            writeFile(text_path, "1 2 3\n");
+            bool wrong_type_refused = false;
+            bool text_refused = false;
+            {
+                ZeroCopyRead reader(text_path.c_str(), lock_path.c_str());
+                convertToColumn(reader, column_path.c_str());
+                try {
+                    ColumnView<std::int64_t> text_as_column(reader);
+                } catch (const std::runtime_error&) {
+                    text_refused = true;
+                }
+            }
+            ZeroCopyRead column_reader(column_path.c_str(), lock_path.c_str());
+            ColumnView<std::int64_t> values(column_reader);
+            try {
+                ColumnView<std::int32_t> wrong(column_reader);
+            } catch (const std::runtime_error&) {
+                wrong_type_refused = true;
+            }
+            std::cout << "[header] " << values.size() << " values, last " << values[2]
+                      << ", text file refused = " << text_refused << ", int32 view of an int64 column refused = "
+                      << wrong_type_refused << "\n";
+            ok = ok && values.size() == 3 && values[2] == 3 && text_refused && wrong_type_refused;
+
+            // 5) A conversion replaces the column under a reader that has it
+            //    mapped: the reader keeps the old values, new readers see
+            //    the new ones. uint64 takes values above INT64_MAX, and
+            //    refuses negative ones and 2^64.
+            writeFile(text_path, "0 -0 9223372036854775808 18446744073709551615\n");
+            {
+                ZeroCopyRead reader(text_path.c_str(), lock_path.c_str());
+                ColumnConvertOptions options;
+                options.type = ColumnType::UInt64;
+                convertToColumn(reader, column_path.c_str(), options);
+            }
+            bool old_mapping_kept = values.size() == 3 && values[0] == 1 && values[2] == 3
+                && access((column_path + ".tmp").c_str(), F_OK) != 0;
+            ZeroCopyRead unsigned_reader(column_path.c_str(), lock_path.c_str());
+            ColumnView<std::uint64_t> unsigned_values(unsigned_reader);
+            bool full_range = unsigned_values.size() == 4 && unsigned_values[1] == 0
+                && unsigned_values[2] == 9223372036854775808ULL && unsigned_values[3] == UINT64_MAX;
+            bool negative_refused = false;
+            bool overflow_refused = false;
+            const std::pair<const char*, bool*> refusals[] = {
+                { "1 -2 3 4 5 6 7 8 9\n", &negative_refused },
+                { "18446744073709551616\n", &overflow_refused },
+            };
+            for (const auto& refusal : refusals) {
+                writeFile(text_path, refusal.first);
+                ZeroCopyRead reader(text_path.c_str(), lock_path.c_str());
+                ColumnConvertOptions options;
+                options.type = ColumnType::UInt64;
+                try {
+                    convertToColumn(reader, column_path.c_str(), options);
+                } catch (const std::runtime_error&) {
+                    *refusal.second = true;
+                }
+            }
+            std::cout << "[replace] old mapping kept = " << old_mapping_kept << ", uint64 above INT64_MAX = "
+                      << full_range << ", negative refused = " << negative_refused << ", 2^64 refused = "
+                      << overflow_refused << "\n";
+            ok = ok && old_mapping_kept && full_range && negative_refused && overflow_refused;
+            unlink(text_path.c_str());
+            unlink(column_path.c_str());
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    unlink(lock_path.c_str());
+
+    std::cout << (ok ? "All column format tests passed.\n" : "Column format tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,80 @@
+// test_line_index.cpp
+// Random line access through LineIndex, including a sidecar round trip.
+
+#include "line-index.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <data_file> <lock_file>\n";
+        return 1;
+    }
+    const char* data_path = argv[1];
+    const char* lock_path = argv[2];
+    const std::string sidecar_path = std::string(data_path) + ".idx";
+    unlink(sidecar_path.c_str());
+
+    try {
+        ZeroCopyRead reader(data_path, lock_path);
+
+        // -- Lazy access: only scans as far as line 1
+        {
+            LineIndex index(reader, sidecar_path.c_str());
+            std::cout << "[line] line(1) = \"" << index.line(1) << "\"\n";
+            std::cout << "[line] indexed " << index.indexedBytes() << " of "
+                      << reader.getFileSize() << " bytes\n";
+
+            std::cout << "[line] lineCount() = " << index.lineCount() << "\n";
+            for (size_t n = 0; n < index.lineCount(); ++n) {
+                std::cout << "  " << n << ": \"" << index.line(n) << "\"\n";
+            }
+            std::cout << "[line] line(99) is empty: " << index.line(99).empty() << "\n";
+
+            std::cout << "[lines] lines(2, 2) =\n" << index.lines(2, 2);
+            std::cout << "[lineAt] byte 20 is on line " << index.lineAt(20) << "\n";
+            index.save();
+        }
+
+        // -- Reload from the sidecar: no scan needed for the complete lines
+        {
+            LineIndex index(reader, sidecar_path.c_str());
+            std::cout << "[sidecar] indexed " << index.indexedBytes()
+                      << " bytes before any access\n";
+            std::cout << "[sidecar] line(3) = \"" << index.line(3) << "\"\n";
+            std::cout << "[sidecar] lineCount() = " << index.lineCount() << "\n";
+        }
+
+        // -- Corrupt sidecars are rebuilt instead of trusted: a huge entry
+        //    count, then offsets that go backwards
+        {
+            size_t expected_lines = LineIndex(reader).lineCount();
+            const std::uint64_t bad_sidecars[2][5] = {
+                { LINE_INDEX_MAGIC, 1ULL << 60, 0, 0, 0 },
+                { LINE_INDEX_MAGIC, 3, 0, 8, 4 },
+            };
+            for (const auto& bad : bad_sidecars) {
+                std::ofstream(sidecar_path, std::ios::binary | std::ios::trunc)
+                    .write(reinterpret_cast<const char*>(bad), sizeof(bad));
+                LineIndex index(reader, sidecar_path.c_str());
+                bool rebuilt = index.indexedBytes() == 0 && index.lineCount() == expected_lines;
+                std::cout << "[sidecar] corrupt sidecar (" << bad[1] << " entries) rebuilt = " << rebuilt << "\n";
+                if (!rebuilt) {
+                    return 1;
+                }
+            }
+            std::cout << "\n";
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    unlink(sidecar_path.c_str());
+    std::cout << "All tests complete.\n";
+    return 0;
+}
@@ -0,0 +1,215 @@
+// test_parallel_scan.cpp
+// Counts records with parallelScan and checks the result against a serial
+// scan, for several thread counts and chunk sizes.
+
+#include "parallel-scan.h"
+#include "record-iterator.h"
+#include "write-library.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+
+static const size_t BENCH_FILE_SIZE = 64 << 20;
+
+struct Counts {
+    size_t records = 0;
+    size_t bytes = 0;
+    size_t longest = 0;
+};
+
+static Counts scanRecords(ZeroCopyRead& reader, const ParallelScanOptions& options) {
+    return parallelScan<Counts>(reader,
+        [](Counts& counts, std::string_view chunk, size_t) {
+            // A chunk holds whole records, so the last one ends the chunk
+            for (size_t start = 0; start < chunk.size();) {
+                size_t end = chunk.find('\n', start);
+                size_t length = (end == std::string_view::npos ? chunk.size() : end) - start;
+                counts.records++;
+                counts.longest = std::max(counts.longest, length);
+                start += length + 1;
+            }
+            counts.bytes += chunk.size();
+        },
+        [](Counts& total, const Counts& counts) {
+            total.records += counts.records;
+            total.bytes += counts.bytes;
+            total.longest = std::max(total.longest, counts.longest);
+        },
+        options);
+}
+
+static double secondsSince(const struct timespec& start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <data_file> <lock_file>\n";
+        return 1;
+    }
+    const char* data_path = argv[1];
+    const char* lock_path = argv[2];
+
+    try {
+        // -- Tiny chunks over the small data file: every boundary case
+        {
+            ZeroCopyRead reader(data_path, lock_path);
+            size_t serial = 0;
+            for (std::string_view record : records(reader)) {
+                (void)record;
+                serial++;
+            }
+            for (size_t chunk_size = 1; chunk_size <= 16; chunk_size *= 2) {
+                ParallelScanOptions options;
+                options.threads = 3;
+                options.chunk_size = chunk_size;
+                Counts counts = scanRecords(reader, options);
+                std::cout << "[small] chunk " << chunk_size << ": " << counts.records << " records, "
+                          << counts.bytes << " bytes (serial " << serial << ", "
+                          << reader.getFileSize() << ")\n";
+                if (counts.records != serial || counts.bytes != reader.getFileSize()) {
+                    std::cerr << "Mismatch on the small file\n";
+                    return 1;
+                }
+            }
+            std::cout << "\n";
+        }
+
+        // -- Generated file with one record longer than several chunks
+        const std::string bench_path = "scan-bench.txt";
+        size_t expected_records = 0;
+        {
+            std::ofstream out(bench_path);
+            out << std::string(5 << 20, 'L') << "\n";
+            expected_records++;
+            size_t written = (5 << 20) + 1;
+            for (size_t i = 0; written < BENCH_FILE_SIZE; ++i) {
+                std::string line = "record-" + std::to_string(i) + "," + std::to_string(i * 7919 % 104729) + "\n";
+                out << line;
+                written += line.size();
+                expected_records++;
+            }
+        }
+
+        ZeroCopyRead reader(bench_path.c_str(), lock_path);
+        size_t size = reader.getFileSize();
+        std::cout << "[bench] " << size / (1 << 20) << " MiB, " << expected_records << " records, "
+                  << std::thread::hardware_concurrency() << " hardware threads\n";
+        for (size_t threads = 1; threads <= 8; threads *= 2) {
+            ParallelScanOptions options;
+            options.threads = threads;
+            options.chunk_size = 1 << 20;
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            Counts counts = scanRecords(reader, options);
+            double seconds = secondsSince(start);
+            std::cout << "  " << threads << " threads: " << size / seconds / (1 << 20) << " MiB/s, "
+                      << counts.records << " records, longest " << counts.longest << "\n";
+            if (counts.records != expected_records || counts.bytes != size) {
+                std::cerr << "Record count mismatch\n";
+                unlink(bench_path.c_str());
+                return 1;
+            }
+        }
+        std::cout << "\n";
+        unlink(bench_path.c_str());
+
+        // -- Scans on a followed file while a writer appends, then seals it:
+        //    workers stay below the scan's snapshot, whatever the writer does
+        const std::string live_path = "scan-live.txt";
+        const size_t preallocated = 8 << 20;  // The writer appends after it
+        {
+            int fd = open(live_path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+            if (fd < 0 || ftruncate(fd, preallocated) != 0) {
+                std::cerr << "Failed to create " << live_path << "\n";
+                return 1;
+            }
+            close(fd);
+        }
+        {
+            WriteLibrary writer(live_path.c_str(), lock_path);
+            std::vector<char> lines;
+            size_t written_lines = 0;
+            auto appendLines = [&](size_t count) {
+                lines.resize(count * 16);
+                for (size_t i = 0; i < count; ++i) {
+                    snprintf(&lines[i * 16], 17, "line-%010zu\n", written_lines++);
+                }
+                writer.writeData(lines.data(), lines.size());
+            };
+            appendLines(1 << 16);
+
+            ZeroCopyReadOptions follow;
+            follow.follow = true;
+            ZeroCopyRead live(live_path.c_str(), lock_path, follow);
+            std::atomic<bool> sealed(false);
+            std::thread writer_thread([&]() {
+                struct timespec pause = { 0, 1000 * 1000 };
+                while (written_lines < (1 << 19)) {
+                    appendLines(4096);
+                    nanosleep(&pause, nullptr);  // Spread the appends over many scans
+                }
+                writer.seal();
+                sealed = true;
+            });
+
+            size_t scans = 0;
+            size_t bad_records = 0;
+            size_t previous_records = 0;
+            bool monotonic = true;
+            bool last_scan = false;
+            while (!last_scan) {
+                last_scan = sealed;
+                ParallelScanOptions options;
+                options.threads = 4;
+                options.chunk_size = 256 << 10;
+                size_t bad = parallelScan<size_t>(live,
+                    [](size_t& count, std::string_view chunk, size_t) {
+                        for (size_t start = 0; start < chunk.size();) {
+                            size_t end = chunk.find('\n', start);
+                            std::string_view record = chunk.substr(start, end - start);
+                            // The first record is the preallocated zeros plus line 0
+                            bool ok = (record.size() == 15 && record.compare(0, 5, "line-") == 0)
+                                   || (!record.empty() && record[0] == '\0');
+                            count += !ok;
+                            start = end == std::string_view::npos ? chunk.size() : end + 1;
+                        }
+                    },
+                    [](size_t& total, const size_t& count) { total += count; },
+                    options);
+                Counts counts = scanRecords(live, options);
+                monotonic = monotonic && counts.records >= previous_records;
+                previous_records = counts.records;
+                bad_records += bad;
+                scans++;
+            }
+            writer_thread.join();
+            bool complete = previous_records == written_lines;
+            std::cout << "[live] " << scans << " scans during appends and the seal, " << bad_records
+                      << " malformed records, counts non-decreasing = " << monotonic << ", last scan saw "
+                      << previous_records << " of " << written_lines << " records, snapshot released = "
+                      << (live.getSnapshotLength() == 0) << "\n\n";
+            if (bad_records != 0 || !monotonic || !complete || live.getSnapshotLength() != 0) {
+                unlink(live_path.c_str());
+                return 1;
+            }
+        }
+        unlink(live_path.c_str());
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "All tests complete.\n";
+    return 0;
+}
@@ -0,0 +1,148 @@
+// test_record_iterator.cpp
+// Iterates records with the SIMD record iterator and compares its throughput
+// with the byte-at-a-time operator++/operator* loop.
+
+#include "record-iterator.h"
+#include "simd-search.h"
+
+#include <algorithm>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <time.h>
+#include <unistd.h>
+
+static const size_t BENCH_FILE_SIZE = 64 << 20;
+static const size_t BYTE_LOOP_SIZE = 1 << 20;
+
+static double secondsSince(const struct timespec& start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " <data_file> <lock_file>\n";
+        return 1;
+    }
+    const char* data_path = argv[1];
+    const char* lock_path = argv[2];
+    std::cout << "findByte implementation: " << findByteImplementation() << "\n\n";
+
+    try {
+        // -- Records of the small data file
+        {
+            ZeroCopyRead reader(data_path, lock_path);
+            std::cout << "[lines]\n";
+            for (auto it = records(reader).begin(); it != records(reader).end(); ++it) {
+                std::cout << "  @" << it.offset() << ": \"" << *it << "\"\n";
+            }
+            std::cout << "[first fields, ',' delimiter]";
+            auto field = records(reader, ',').begin();
+            for (int i = 0; i < 2; ++i, ++field) {
+                std::cout << " \"" << *field << "\"";
+            }
+            std::cout << "\n\n";
+        }
+
+        // -- A record still being appended: a follower stops before it and
+        //    yields it whole on the next pass, a fixed reader yields the tail
+        {
+            const std::string tail_path = "records-tail.txt";
+            int fd = open(tail_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0666);
+            if (fd < 0 || write(fd, "alpha\nbe", 8) != 8) {
+                throw std::runtime_error("write failed");
+            }
+            ZeroCopyReadOptions follow;
+            follow.follow = true;
+            ZeroCopyRead follower(tail_path.c_str(), lock_path, follow);
+            std::vector<std::string> seen;
+            size_t next = 0;
+            for (auto it = records(follower).begin(); it != records(follower).end(); ++it) {
+                seen.emplace_back(*it);
+                next = it.offset() + it->size() + 1;
+            }
+            size_t first_pass = seen.size();
+            if (write(fd, "ta\ngam", 6) != 6) {
+                throw std::runtime_error("write failed");
+            }
+            for (std::string_view record : records(follower, '\n', next)) {
+                seen.emplace_back(record);
+            }
+            close(fd);
+            ZeroCopyRead fixed(tail_path.c_str(), lock_path);
+            std::string last;
+            for (std::string_view record : records(fixed)) {
+                last = std::string(record);
+            }
+            bool whole = first_pass == 1 && seen.size() == 2 && seen[0] == "alpha" && seen[1] == "beta";
+            std::cout << "[follow] partial record held back, then yielded whole = " << whole
+                      << ", fixed reader yields the tail \"" << last << "\"\n\n";
+            unlink(tail_path.c_str());
+            if (!whole || last != "gam") {
+                return 1;
+            }
+        }
+
+        // -- Throughput on a generated file of paths, with one record much
+        //    longer than the iterator window
+        const std::string bench_path = "records-bench.txt";
+        size_t expected_records = 0;
+        {
+            std::ofstream out(bench_path);
+            out << std::string(3 * RECORD_WINDOW_SIZE, 'L') << "\n";
+            expected_records++;
+            size_t written = 3 * RECORD_WINDOW_SIZE + 1;
+            for (size_t i = 0; written < BENCH_FILE_SIZE; ++i) {
+                std::string path = "/mnt/famfs-mount/dataset/part-" + std::to_string(i % 9973)
+                                 + "/file-" + std::to_string(i) + ".bin\n";
+                out << path;
+                written += path.size();
+                expected_records++;
+            }
+        }
+
+        ZeroCopyRead reader(bench_path.c_str(), lock_path);
+        size_t size = reader.getFileSize();
+
+        struct timespec start;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        size_t count = 0;
+        size_t longest = 0;
+        for (std::string_view record : records(reader)) {
+            count++;
+            longest = std::max(longest, record.size());
+        }
+        double iterator_seconds = secondsSince(start);
+
+        reader.resetIterator();
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        size_t byte_loop_newlines = 0;
+        for (size_t i = 0; i < BYTE_LOOP_SIZE; ++i) {
+            byte_loop_newlines += (*reader == '\n');
+            ++reader;
+        }
+        double byte_loop_seconds = secondsSince(start);
+
+        std::cout << "[bench] " << size / (1 << 20) << " MiB, " << count << " records (expected "
+                  << expected_records << "), longest " << longest << " bytes\n";
+        std::cout << "  RecordIterator:   " << size / iterator_seconds / (1 << 20) << " MiB/s\n";
+        std::cout << "  operator++ loop:  " << BYTE_LOOP_SIZE / byte_loop_seconds / (1 << 20)
+                  << " MiB/s (first " << BYTE_LOOP_SIZE / (1 << 20) << " MiB)\n\n";
+        unlink(bench_path.c_str());
+
+        if (count != expected_records) {
+            std::cerr << "Record count mismatch\n";
+            return 1;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    std::cout << "All tests complete.\n";
+    return 0;
+}
@@ -0,0 +1,242 @@
+// test_ring_channel.cpp
+// Sends messages through a ring file: one producer thread, several producer
+// threads, a full ring, a producer in another process, and capacity limits.
+
+#include "ring-channel.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <time.h>
+
+// Message i: its index, then bytes derived from it; lengths vary so records
+// wrap at every possible offset
+static std::string makeMessage(std::uint64_t i) {
+    std::string message(sizeof(i) + i % 200, static_cast<char>('a' + i % 26));
+    memcpy(&message[0], &i, sizeof(i));
+    return message;
+}
+
+static double secondsSince(const struct timespec& start) {
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc != 2) {
+        std::cerr << "Usage: " << argv[0] << " <ring_file>\n";
+        return 1;
+    }
+    const std::string ring_path = argv[1];
+    bool ok = true;
+
+    try {
+        // 1) One producer thread, zero-copy on both sides, 64 KiB ring
+        {
+            unlink(ring_path.c_str());
+            RingChannelOptions options;
+            options.capacity = 64 * 1024;
+            options.multi_producer = false;
+            const std::uint64_t count = 200000;
+            RingConsumer consumer(ring_path.c_str(), options);
+            struct timespec start;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            std::thread producer_thread([&]() {
+                RingProducer producer(ring_path.c_str(), options);
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    std::string message = makeMessage(i);
+                    RingReservation slot = producer.reserve(message.size());
+                    memcpy(slot.data, message.data(), message.size());
+                    producer.commit(slot);
+                }
+                producer.close();
+            });
+            std::uint64_t received = 0;
+            bool in_order = true;
+            std::string_view message;
+            while (consumer.peek(&message, -1)) {
+                in_order = in_order && message == makeMessage(received);
+                received++;
+                consumer.release();
+            }
+            producer_thread.join();
+            double seconds = secondsSince(start);
+            std::cout << "[SPSC] " << received << " of " << count << " messages, in order = " << in_order
+                      << ", " << static_cast<long long>(received / seconds) << " msg/s, ring empty = "
+                      << (consumer.used() == 0) << "\n";
+            ok = ok && received == count && in_order;
+        }
+
+        // 2) Three producer threads sharing the tail; each one's messages
+        //    arrive in the order it sent them
+        {
+            unlink(ring_path.c_str());
+            RingChannelOptions options;
+            options.capacity = 16 * 1024;
+            const int producers = 3;
+            const std::uint64_t per_producer = 50000;
+            RingConsumer consumer(ring_path.c_str(), options);
+            std::vector<std::thread> threads;
+            for (int p = 0; p < producers; ++p) {
+                threads.emplace_back([&, p]() {
+                    RingProducer producer(ring_path.c_str(), options);
+                    for (std::uint64_t i = 0; i < per_producer; ++i) {
+                        std::uint64_t message[2] = { static_cast<std::uint64_t>(p), i };
+                        producer.send(message, sizeof(message));
+                    }
+                });
+            }
+            std::vector<std::uint64_t> next(producers, 0);
+            bool in_order = true;
+            std::string_view message;
+            for (std::uint64_t received = 0; received < producers * per_producer; ++received) {
+                if (!consumer.peek(&message, 10000)) {
+                    in_order = false;
+                    break;
+                }
+                std::uint64_t fields[2];
+                memcpy(fields, message.data(), sizeof(fields));
+                in_order = in_order && fields[0] < static_cast<std::uint64_t>(producers) && fields[1] == next[fields[0]];
+                next[fields[0]]++;
+                consumer.release();
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            std::cout << "[MPSC] " << producers << " producers x " << per_producer << " messages, per-producer order = "
+                      << in_order << "\n";
+            ok = ok && in_order;
+        }
+
+        // 3) Backpressure: a full ring refuses, one release makes room
+        {
+            unlink(ring_path.c_str());
+            RingChannelOptions options;
+            options.capacity = 4096;
+            options.wait = RingWait::Poll;
+            RingConsumer consumer(ring_path.c_str(), options);
+            RingProducer producer(ring_path.c_str(), options);
+            char payload[56] = {};
+            int accepted = 0;
+            while (producer.send(payload, sizeof(payload), 0)) {
+                accepted++;
+            }
+            bool refused_when_full = !producer.send(payload, sizeof(payload), 5);
+            std::string_view message;
+            consumer.peek(&message);
+            consumer.release();
+            bool accepted_after_release = producer.send(payload, sizeof(payload), 0);
+            bool too_large = false;
+            try {
+                producer.reserve(consumer.maxMessageSize() + 1, 0);
+            } catch (const std::invalid_argument&) {
+                too_large = true;
+            }
+            std::cout << "[Backpressure] " << accepted << " x 64-byte records fill 4096 bytes, refused when full = "
+                      << refused_when_full << ", accepted after a release = " << accepted_after_release
+                      << ", oversized message rejected = " << too_large << "\n";
+            ok = ok && accepted == 64 && refused_when_full && accepted_after_release && too_large;
+        }
+
+        // 4) Producer in another process; the consumer blocks on the wake word
+        {
+            unlink(ring_path.c_str());
+            RingChannelOptions options;
+            options.capacity = 64 * 1024;
+            RingConsumer consumer(ring_path.c_str(), options);
+            const std::uint64_t count = 100000;
+            pid_t pid = fork();
+            if (pid == 0) {
+                RingProducer producer(ring_path.c_str(), options);
+                for (std::uint64_t i = 0; i < count; ++i) {
+                    std::string message = makeMessage(i);
+                    producer.send(message.data(), message.size());
+                }
+                producer.close();
+                _exit(0);
+            }
+            std::uint64_t received = 0;
+            bool in_order = true;
+            std::string_view message;
+            while (consumer.peek(&message, 10000)) {
+                in_order = in_order && message == makeMessage(received);
+                received++;
+                consumer.release();
+            }
+            int status = 0;
+            waitpid(pid, &status, 0);
+            std::cout << "[Process] " << received << " of " << count << " messages from another process, in order = "
+                      << in_order << ", closed = " << consumer.isClosed() << "\n";
+            ok = ok && received == count && in_order && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+        }
+
+        // 5) A new consumer resumes at the released head
+        {
+            unlink(ring_path.c_str());
+            RingChannelOptions options;
+            options.capacity = 4096;
+            {
+                RingProducer producer(ring_path.c_str(), options);
+                for (std::uint64_t i = 0; i < 3; ++i) {
+                    std::string message = makeMessage(i);
+                    producer.send(message.data(), message.size());
+                }
+            }
+            std::string_view message;
+            {
+                RingConsumer first(ring_path.c_str(), options);
+                first.peek(&message);
+                first.release();
+            }
+            RingConsumer second(ring_path.c_str(), options);
+            bool resumed = second.peek(&message) && message == makeMessage(1);
+            std::cout << "[Resume] second consumer starts at message 1 = " << resumed << "\n";
+            ok = ok && resumed;
+        }
+
+        // 6) Capacities whose records would overflow the length bits are
+        //    refused, whether requested or read from an existing header
+        {
+            unlink(ring_path.c_str());
+            RingChannelOptions options;
+            options.capacity = RING_MAX_CAPACITY * 2;
+            bool too_large_refused = false;
+            try {
+                RingProducer producer(ring_path.c_str(), options);
+            } catch (const std::invalid_argument&) {
+                too_large_refused = true;
+            }
+            std::uint64_t forged[RING_HEADER_SIZE / sizeof(std::uint64_t)] = { RING_MAGIC, RING_MAX_CAPACITY * 2 };
+            FILE* file = fopen(ring_path.c_str(), "wb");
+            bool forged_written = file != nullptr && fwrite(forged, sizeof(forged), 1, file) == 1;
+            if (file != nullptr) {
+                fclose(file);
+            }
+            bool corrupt_refused = false;
+            try {
+                options.capacity = 4096;
+                RingConsumer consumer(ring_path.c_str(), options);
+            } catch (const std::runtime_error&) {
+                corrupt_refused = true;
+            }
+            std::cout << "[Capacity] above " << RING_MAX_CAPACITY << " bytes refused = " << too_large_refused
+                      << ", in an existing header = " << corrupt_refused << "\n";
+            ok = ok && too_large_refused && forged_written && corrupt_refused;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Error: " << ex.what() << "\n";
+        return 1;
+    }
+    unlink(ring_path.c_str());
+
+    std::cout << (ok ? "All ring channel tests passed.\n" : "Ring channel tests FAILED.\n");
+    return ok ? 0 : 1;
+}
@@ -1,16 +1,43 @@
 // test_write.cpp
 
 #include "write-library.h"
+#include "mapped-write-library.h"
+#include "zero-copy-read-library.h"
 
 #include <fcntl.h>
 #include <unistd.h>
 #include <sys/stat.h>
+#include <sys/xattr.h>
 #include <iostream>
 #include <fstream>
 #include <vector>
 #include <cstdlib>
 #include <cerrno>
 #include <cstring>
+#include <time.h>
+
+// Create path and size it to BLOCK_SIZE, as `famfs creat -s 2M` would
+static bool preallocate(const std::string& path) {
+    int df = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+    if (df < 0) {
+        std::cerr << "open(" << path << "): " << std::strerror(errno) << "\n";
+        return false;
+    }
+    bool ok = ftruncate(df, BLOCK_SIZE) == 0;
+    close(df);
+    return ok;
+}
+
+template <typename Writer>
+static long long nsPerMessage(Writer& writer, const std::string& msg, int count) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count; ++i) {
+        writer.writeData(msg.c_str(), msg.size());
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec)) / count;
+}
 
 int main(int argc, char* argv[]) {
     if (argc != 3) {
@@ -82,5 +109,269 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // 5) Mapped writer: store the same messages through the mapping and read
+    //    them back up to the committed length
+    std::string mapped_path = std::string(data_path) + ".mapped";
+    if (!preallocate(mapped_path)) {
+        return 1;
+    }
+    try {
+        MappedWriteLibrary writer(mapped_path.c_str(), lock_path);
+        std::cout << "\n[Test] Mapped writer flush method: " << writer.getFlushMethodName() << "\n";
+        for (const char* msg : {"Hello, mapped world!\n", "Second mapped line.\n"}) {
+            writer.writeData(msg, strlen(msg));
+        }
+        ZeroCopyRead reader(mapped_path.c_str(), lock_path);
+        std::cout << "[Test] Reader sees " << reader.getFileSize() << " of "
+                  << writer.getCapacity() << " bytes:\n"
+                  << reader.view(0, reader.getFileSize());
+        // The msync fallback syncs the payload pages and the control block
+        MappedWriteOptions options;
+        options.persist = PersistMode::Msync;
+        MappedWriteLibrary msync_writer(mapped_path.c_str(), lock_path, options);
+        const std::string line = "Synced mapped line.\n";
+        msync_writer.writeData(line.c_str(), line.size());
+        ZeroCopyRead msync_reader(mapped_path.c_str(), lock_path);
+        std::cout << "[Test] Mapped writer flush method: " << msync_writer.getFlushMethodName()
+                  << ", reader sees the synced line = "
+                  << (msync_reader.view(msync_reader.getFileSize() - line.size(), line.size()) == line) << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "MappedWriteLibrary error: " << ex.what() << "\n";
+        return 1;
+    }
+
+    // 6) Per-message cost of the syscall writer against the mapped writer
+    try {
+        const int count = 10000;
+        const std::string msg(63, 'm');
+        // Separate files so each writer starts from an empty file
+        std::string bench_path = std::string(data_path) + ".bench";
+        const std::string paths[] = {bench_path + "-syscall", bench_path + "-mapped", bench_path + "-noflush"};
+        for (const std::string& path : paths) {
+            preallocate(path);
+        }
+        long long syscall_ns;
+        {
+            WriteLibrary writer(paths[0].c_str(), lock_path);
+            syscall_ns = nsPerMessage(writer, msg + "\n", count);
+        }
+        long long mapped_ns;
+        {
+            MappedWriteLibrary writer(paths[1].c_str(), lock_path);
+            mapped_ns = nsPerMessage(writer, msg + "\n", count);
+        }
+        long long unflushed_ns;
+        {
+            MappedWriteOptions options;
+            options.persist = PersistMode::None;
+            MappedWriteLibrary writer(paths[2].c_str(), lock_path, options);
+            unflushed_ns = nsPerMessage(writer, msg + "\n", count);
+        }
+        for (const std::string& path : paths) {
+            unlink(path.c_str());
+        }
+        std::cout << "\n[Bench] " << count << " x " << msg.size() + 1 << "-byte messages\n"
+                  << "  WriteLibrary (write syscall): " << syscall_ns << " ns/msg\n"
+                  << "  MappedWriteLibrary (flushed): " << mapped_ns << " ns/msg\n"
+                  << "  MappedWriteLibrary (no flush): " << unflushed_ns << " ns/msg\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "Benchmark error: " << ex.what() << "\n";
+        return 1;
+    }
+    unlink(mapped_path.c_str());
+
+    // 7) Batched writes: iovecs and beginBatch()/commit() share one
+    //    lock/unlock cycle and one durability check
+    std::string batch_path = std::string(data_path) + ".batch";
+    if (!preallocate(batch_path)) {
+        return 1;
+    }
+    try {
+        const int count = 10000;
+        const std::string msg(63, 'b');
+        std::string line = msg + "\n";
+        struct timespec start, end;
+        WriteLibrary writer(batch_path.c_str(), lock_path);
+
+        std::vector<struct iovec> iov(count, { const_cast<char*>(line.data()), line.size() });
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        writer.writeBatch(iov.data(), count);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        long long iov_ns = ((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec)) / count;
+
+        DurabilityOptions durability;
+        durability.mode = Durability::PerBatch;
+        writer.setDurability(durability);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        writer.beginBatch();
+        for (int i = 0; i < count; ++i) {
+            writer.writeData(line.c_str(), line.size());
+        }
+        writer.commit();
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        long long staged_ns = ((end.tv_sec - start.tv_sec) * 1000000000LL + (end.tv_nsec - start.tv_nsec)) / count;
+
+        durability.mode = Durability::GroupCommit;
+        writer.setDurability(durability);
+        long long group_ns = nsPerMessage(writer, line, count);
+
+        std::cout << "\n[Bench] " << count << " x " << line.size() << "-byte messages, batched\n"
+                  << "  writeBatch (iovecs, no sync): " << iov_ns << " ns/msg\n"
+                  << "  beginBatch/commit (one sync): " << staged_ns << " ns/msg\n"
+                  << "  writeData (group commit):     " << group_ns << " ns/msg\n";
+        std::cout << "[Stats] " << formatStats(writer.stats()) << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "Batch error: " << ex.what() << "\n";
+        return 1;
+    }
+    {
+        struct stat batch_stat;
+        stat(batch_path.c_str(), &batch_stat);
+        std::cout << "[Test] Batched file grew by " << batch_stat.st_size - BLOCK_SIZE << " bytes\n";
+    }
+    unlink(batch_path.c_str());
+
+    // 8) Sealing: a reader opened before the seal goes coordination-free on
+    //    its next access, one opened after it sees the marker on the file
+    std::string sealed_path = std::string(data_path) + ".sealed";
+    unlink(sealed_path.c_str());  // The seal marker survives truncation
+    if (!preallocate(sealed_path)) {
+        return 1;
+    }
+    try {
+        WriteLibrary writer(sealed_path.c_str(), lock_path);
+        const std::string line = "sealed line\n";
+        writer.writeData(line.c_str(), line.size());
+        ZeroCopyRead before(sealed_path.c_str(), lock_path);
+        before.view(0, 1);
+        bool enforced = writer.seal(true);
+        before.view(0, 1);
+        std::uint64_t lock_checks = before.stats().lock_checks;
+        for (int i = 0; i < 1000; ++i) {
+            before.view(0, before.getFileSize());
+        }
+        bool refused = false;
+        try {
+            writer.writeData(line.c_str(), line.size());
+        } catch (const std::runtime_error&) {
+            refused = true;
+        }
+        ZeroCopyRead after(sealed_path.c_str(), lock_path);
+        std::cout << "\n[Seal] enforced = " << enforced << ", reader before sealed = " << before.isSealed()
+                  << " (lock checks after the seal: " << before.stats().lock_checks - lock_checks
+                  << "), reader after sealed = " << after.isSealed()
+                  << " at " << after.getFileSize() << " bytes, write refused = " << refused << "\n";
+    } catch (const std::exception& ex) {
+        std::cerr << "Seal error: " << ex.what() << "\n";
+        return 1;
+    }
+    try {
+        // A new writer on the sealed file keeps it sealed
+        WriteLibrary writer(sealed_path.c_str(), lock_path);
+        std::cout << "[Seal] reopened writer sealed = " << writer.isSealed() << "\n";
+    } catch (const std::exception& ex) {
+        std::cout << "[Seal] reopening the sealed file refused: " << ex.what() << "\n";
+    }
+    try {
+        // unseal() reopens the file for writes; readers opened after it follow
+        // the writer again
+        WriteLibrary writer(sealed_path.c_str(), lock_path);
+        writer.unseal();
+        const std::string line = "after unseal\n";
+        writer.writeData(line.c_str(), line.size());
+        ZeroCopyRead reader(sealed_path.c_str(), lock_path);
+        bool reopened = !writer.isSealed() && !reader.isSealed()
+            && reader.view(reader.getFileSize() - line.size(), line.size()) == line;
+        writer.seal();
+        std::cout << "[Seal] unsealed, written and read back = " << reopened << "\n";
+        if (!reopened) {
+            unlink(sealed_path.c_str());
+            return 1;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Unseal error: " << ex.what() << "\n";
+        return 1;
+    }
+    {
+        // A marker that no longer matches the file is ignored: a fresh lock
+        // file leaves readers only the marker to go by
+        std::string fresh_lock = sealed_path + ".lock";
+        int lf = open(fresh_lock.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+        bool lock_ok = lf >= 0 && ftruncate(lf, 1) == 0;
+        if (lf >= 0) {
+            close(lf);
+        }
+        int df = open(sealed_path.c_str(), O_WRONLY | O_APPEND);
+        bool appended = df >= 0 && write(df, "x", 1) == 1;
+        bool resized_ignored = false;
+        bool past_end_ignored = false;
+        if (lock_ok && appended) {
+            ZeroCopyRead resized(sealed_path.c_str(), fresh_lock.c_str());
+            resized_ignored = !resized.isSealed();
+            // Forge a marker for this inode and size whose length runs past the end
+            struct stat file_stat;
+            fstat(df, &file_stat);
+            std::string forged = std::to_string(file_stat.st_size + 4096) + " " + std::to_string(file_stat.st_ino)
+                + " " + std::to_string(file_stat.st_size);
+            fsetxattr(df, SEAL_XATTR, forged.data(), forged.size(), 0);
+            ZeroCopyRead past_end(sealed_path.c_str(), fresh_lock.c_str());
+            past_end_ignored = !past_end.isSealed();
+        }
+        if (df >= 0) {
+            close(df);
+        }
+        unlink(fresh_lock.c_str());
+        std::cout << "[Seal] stale marker ignored after a resize = " << resized_ignored
+                  << ", past the end of the file = " << past_end_ignored << "\n";
+        if (!resized_ignored || !past_end_ignored) {
+            unlink(sealed_path.c_str());
+            return 1;
+        }
+    }
+    unlink(sealed_path.c_str());
+
+    // 9) Staged batches keep the call order whatever the call, and group
+    //    commit syncs an idle writer once the interval has passed
+    std::string order_path = std::string(data_path) + ".order";
+    if (!preallocate(order_path)) {
+        return 1;
+    }
+    try {
+        WriteLibrary writer(order_path.c_str(), lock_path);
+        DurabilityOptions durability;
+        durability.mode = Durability::GroupCommit;
+        durability.group_commit_bytes = 1 << 30;
+        durability.group_commit_interval = std::chrono::milliseconds(20);
+        writer.setDurability(durability);
+        writer.flush();
+
+        const std::string first = "first\n", second = "second\n", third = "third\n";
+        struct iovec iov = { const_cast<char*>(second.data()), second.size() };
+        writer.beginBatch();
+        writer.writeData(first.c_str(), first.size());
+        writer.writeBatch(&iov, 1);
+        writer.writeData(third.c_str(), third.size());
+        writer.commit();
+        std::uint64_t syncs_after_write = writer.stats().syncs;
+        struct timespec idle = { 0, 200 * 1000 * 1000 };
+        nanosleep(&idle, nullptr);
+        std::uint64_t syncs_after_idle = writer.stats().syncs;
+
+        ZeroCopyRead reader(order_path.c_str(), lock_path);
+        std::string_view tail = reader.view(BLOCK_SIZE, reader.getFileSize() - BLOCK_SIZE);
+        bool in_order = tail == first + second + third;
+        bool idle_synced = syncs_after_idle > syncs_after_write;
+        std::cout << "\n[Order] staged writeData/writeBatch/writeData in order = " << in_order
+                  << "\n[GroupCommit] idle writer synced by the flusher = " << idle_synced << "\n";
+        if (!in_order || !idle_synced) {
+            unlink(order_path.c_str());
+            return 1;
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << "Order error: " << ex.what() << "\n";
+        return 1;
+    }
+    unlink(order_path.c_str());
+
     return 0;
 }
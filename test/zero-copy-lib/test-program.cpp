@@ -1,6 +1,9 @@
 // test_zero_copy.cpp
 
 #include "zero-copy-read-library.h"
+#include "typed-view.h"
+#include "zip-kernels.h"
+#include "zero-copy-read-set.h"
 
 #include <iostream>
 #include <fstream>
@@ -9,6 +12,13 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <thread>
+#include <numeric>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <cstdint>
+#include <cstddef>
 
 int main(int argc, char* argv[]) {
     if (argc != 3) {
@@ -40,17 +50,413 @@ int main(int argc, char* argv[]) {
                       << buf.data() << "\n\n";
         }
 
-        // -- Test atomicReadLine()
-        // First, write a line into the lock file so atomicReadLine returns it
+        // -- Test view()
         {
-            std::ofstream lofs(lock_path, std::ios::trunc);
-            lofs << "LOCKWORD\n";  
+            std::string_view full = reader.view(0, sz);
+            std::cout << "[view] full contents (" << full.size() << " bytes):\n"
+                      << full << "\n";
+            std::string_view middle = reader.view(2, 3);
+            std::cout << "[view] 3 bytes at offset 2: \"" << middle << "\"\n";
+            std::string_view past_end = reader.view(sz - 1, 2);
+            std::cout << "[view] out of bounds: " << (past_end.empty() ? "empty" : "NOT EMPTY") << "\n\n";
         }
+
+        // -- Test the control block protocol
+        // Act as a writer: publish this data file and a committed length,
+        // then hold the lock briefly from another thread.
+        {
+            int lock_fd = open(lock_path, O_RDWR);
+            ControlBlock* block = mapControlBlock(lock_fd);
+            struct stat data_stat;
+            stat(data_path, &data_stat);
+            block->sequence.store(0, std::memory_order_relaxed);
+            block->file_dev.store(data_stat.st_dev, std::memory_order_relaxed);
+            block->file_ino.store(data_stat.st_ino, std::memory_order_relaxed);
+            block->committed_length.store(sz - 1, std::memory_order_relaxed);
+            block->magic.store(CONTROL_BLOCK_MAGIC, std::memory_order_release);
+            std::cout << "[control block] committed length = "
+                      << reader.getCommittedLength() << "\n";
+
+            beginControlBlockWrite(block);
+            std::atomic<std::int64_t> unlocked_at{0};
+            std::thread unlocker([block, sz, &unlocked_at]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                unlocked_at.store(std::chrono::steady_clock::now().time_since_epoch().count());
+                endControlBlockWrite(block, sz);
+            });
+            reader.readLockfile();  // Blocks until the unlocker runs
+            std::chrono::steady_clock::duration handoff(
+                std::chrono::steady_clock::now().time_since_epoch().count() - unlocked_at.load());
+            std::cout << "[control block] after unlock, committed length = "
+                      << reader.getCommittedLength() << ", waited for the writer = "
+                      << (reader.stats().lock_wait_ns > 0) << "\n";
+            // The reader sleeps on the futex, so the unlock wakes it at once
+            // instead of at its next 100 ms poll
+            std::cout << "[control block] woken within 20 ms of the unlock = "
+                      << (handoff < std::chrono::milliseconds(20)) << "\n";
+            unlocker.join();
+
+            // waitForBytes in follow mode sleeps until the writer's next commit
+            {
+                ZeroCopyReadOptions options;
+                options.follow = true;
+                ZeroCopyRead follower(data_path, lock_path, options);
+                std::thread committer([block, sz]() {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                    beginControlBlockWrite(block);
+                    endControlBlockWrite(block, sz);
+                });
+                block->committed_length.store(sz - 1, std::memory_order_release);
+                follower.refresh();
+                auto wait_start = std::chrono::steady_clock::now();
+                size_t size = follower.waitForBytes(sz, 5000);
+                committer.join();
+                std::cout << "[control block] waitForBytes woken by the commit: size = " << size
+                          << ", before the timeout = "
+                          << (std::chrono::steady_clock::now() - wait_start < std::chrono::seconds(1))
+                          << "\n\n";
+            }
+
+            // -- Test snapshot reads: bytes below the watermark are read
+            // while the writer is stuck in the middle of an append
+            {
+                ReadSnapshot pinned = reader.snapshot();
+                beginControlBlockWrite(block);
+                std::uint64_t checks = reader.stats().lock_checks;
+                std::string_view committed = reader.view(0, pinned.length);
+                ReaderStats after = reader.stats();
+                std::cout << "[snapshot] length = " << pinned.length << ", read " << committed.size()
+                          << " bytes while the writer holds the lock, lock checks = "
+                          << after.lock_checks - checks << ", snapshot reads = " << after.snapshot_reads << "\n\n";
+                endControlBlockWrite(block, sz);
+                reader.releaseSnapshot();
+            }
+
+            // Leave the block to a real writer
+            block->magic.store(0, std::memory_order_release);
+            unmapControlBlock(block);
+            close(lock_fd);
+        }
+
+        // -- Test follow mode
+        {
+            const std::string follow_path = "follow-test.txt";
+            int wfd = open(follow_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0666);
+            if (write(wfd, "first\n", 6) != 6) {
+                throw std::runtime_error("write failed");
+            }
+
+            ZeroCopyReadOptions options;
+            options.follow = true;
+            options.reserve_size = 4096;  // Small, so the reservation has to grow
+            ZeroCopyRead follower(follow_path.c_str(), lock_path, options);
+            std::cout << "[follow] initial size = " << follower.getFileSize() << "\n";
+
+            std::string appended(8192, 'a');
+            appended.back() = '\n';
+            std::thread appender([wfd, &appended]() {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                if (write(wfd, appended.data(), appended.size()) < 0) {
+                    perror("write");
+                }
+            });
+            size_t size = follower.waitForBytes(6 + appended.size(), 5000);
+            appender.join();
+            close(wfd);
+            std::cout << "[follow] after append, size = " << size
+                      << ", first line = \"" << follower.view(0, 5) << "\""
+                      << ", ends with newline = " << (follower.view(size - 1, 1) == "\n") << "\n";
+
+            // Replace the file under the same path, as the famfs growth path does
+            {
+                std::ofstream replacement(follow_path + ".new");
+                replacement << "replaced\n";
+            }
+            rename((follow_path + ".new").c_str(), follow_path.c_str());
+            size = follower.refresh();
+            std::cout << "[follow] after replace, size = " << size
+                      << ", contents = \"" << follower.view(0, 8) << "\"\n\n";
+            unlink(follow_path.c_str());
+        }
+
+        // -- Test a writer-published replacement: the new file is
+        //    preallocated past the committed length, which still bounds the
+        //    follower
         {
-            char line[MAX_BUFFER_SIZE];
-            size_t len = reader.atomicReadLine(line);
-            line[len] = '\0';
-            std::cout << "[atomicReadLine] got: \"" << line << "\" (len=" << len << ")\n\n";
+            const std::string grown_path = "follow-grown.txt";
+            const std::string grown_lock = "follow-grown.lock";
+            const std::string committed = "committed\n";
+            int lock_fd = open(grown_lock.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0666);
+            ControlBlock* block = mapControlBlock(lock_fd);
+            claimControlBlock(block);
+            int wfd = open(grown_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0666);
+            if (write(wfd, committed.data(), committed.size()) != static_cast<ssize_t>(committed.size())) {
+                throw std::runtime_error("write failed");
+            }
+            publishFileIdentity(block, wfd, committed.size(), lock_fd);
+            close(wfd);
+
+            ZeroCopyReadOptions options;
+            options.follow = true;
+            ZeroCopyRead follower(grown_path.c_str(), grown_lock.c_str(), options);
+
+            // Copy to a larger preallocated file and publish its inode, as
+            // the famfs growth path does
+            const size_t preallocated = 64 * 1024;
+            wfd = open((grown_path + ".new").c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0666);
+            if (write(wfd, committed.data(), committed.size()) != static_cast<ssize_t>(committed.size())
+                || ftruncate(wfd, preallocated) != 0) {
+                throw std::runtime_error("write failed");
+            }
+            rename((grown_path + ".new").c_str(), grown_path.c_str());
+            publishFileIdentity(block, wfd, committed.size(), lock_fd);
+            size_t after_replace = follower.refresh();
+            if (pwrite(wfd, committed.data(), committed.size(), committed.size())
+                != static_cast<ssize_t>(committed.size())) {
+                throw std::runtime_error("write failed");
+            }
+            beginControlBlockWrite(block);
+            endControlBlockWrite(block, 2 * committed.size(), lock_fd);
+            size_t after_commit = follower.refresh();
+            std::cout << "[follow] replaced by a " << preallocated << "-byte preallocated file: size = "
+                      << after_replace << ", after the next commit = " << after_commit << "\n\n";
+            close(wfd);
+            unmapControlBlock(block);
+            close(lock_fd);
+            unlink(grown_path.c_str());
+            unlink(grown_lock.c_str());
+            if (after_replace != committed.size() || after_commit != 2 * committed.size()) {
+                return 1;
+            }
+        }
+
+        // -- Test the access-pattern options: same bytes through every hint
+        {
+            ZeroCopyReadOptions options;
+            options.access = AccessPattern::WillNeed;
+            options.willneed_length = 4;
+            options.populate = true;
+            options.prefetch_distance = 8192;
+            ZeroCopyRead hinted(data_path, lock_path, options);
+            hinted += 2;
+            std::cout << "[access hints] view matches = " << (hinted.view(0, sz) == reader.view(0, sz))
+                      << ", at pos 2: '" << *hinted << "'\n\n";
+        }
+
+        // -- Test huge-page mode, fixed and following; huge pages themselves
+        //    depend on the backing and the THP settings
+        {
+            ZeroCopyReadOptions options;
+            options.huge_pages = true;
+            ZeroCopyRead huge(data_path, lock_path, options);
+            options.follow = true;
+            options.reserve_size = 4096;
+            ZeroCopyRead huge_follower(data_path, lock_path, options);
+            std::cout << "[huge pages] 2 MiB aligned = "
+                      << (reinterpret_cast<uintptr_t>(huge.view(0, 1).data()) % HUGE_PAGE_SIZE == 0)
+                      << ", views match = " << (huge.view(0, sz) == reader.view(0, sz)
+                                                 && huge_follower.view(0, sz) == reader.view(0, sz))
+                      << ", huge page bytes = " << huge.getHugePageBytes() << "\n\n";
+        }
+
+        // -- Test the read backends: the same bytes mapped and read through
+        //    io_uring in small blocks, fixed and following
+        {
+            const std::string io_path = "io-test.bin";
+            std::string contents(3 * 1024 * 1024 + 123, '\0');
+            for (size_t i = 0; i < contents.size(); ++i) {
+                contents[i] = static_cast<char>('a' + (i * 7) % 26);
+            }
+            {
+                std::ofstream out(io_path, std::ios::binary);
+                out.write(contents.data(), contents.size());
+            }
+            int probe = open(io_path.c_str(), O_RDONLY);
+            StorageInfo info = detectStorage(probe);
+            close(probe);
+            std::cout << "[backend] " << io_path << " is on " << info.fs_name << ", dax = " << info.dax
+                      << ", auto picks " << backendName(info.preferred) << "\n";
+
+            ZeroCopyReadOptions options;
+            options.backend = ReadBackend::Mmap;
+            ZeroCopyRead mapped(io_path.c_str(), lock_path, options);
+            options.backend = ReadBackend::IoUring;
+            options.io_engine.block_size = 64 * 1024;
+            options.io_engine.queue_depth = 4;
+            options.io_engine.readahead = 256 * 1024;
+            ZeroCopyRead uring(io_path.c_str(), lock_path, options);
+
+            // Scattered ranges first, then the iterator across several blocks
+            std::string_view expected(contents);
+            bool ranges_match = true;
+            for (size_t offset : { size_t(2000000), size_t(17), size_t(65530), contents.size() - 10 }) {
+                ranges_match = ranges_match && uring.view(offset, 10) == expected.substr(offset, 10);
+            }
+            bool iterator_matches = true;
+            for (size_t i = 0; i < 200000 && iterator_matches; ++i, ++uring) {
+                iterator_matches = *uring == contents[i];
+            }
+            std::cout << "[backend] " << backendName(mapped.getBackend()) << " and "
+                      << backendName(uring.getBackend()) << " ("
+                      << (uring.getIoEngine()->usesIoUring() ? "io_uring" : "pread fallback")
+                      << "): ranges match = " << ranges_match
+                      << ", iterator matches = " << iterator_matches
+                      << ", full views match = " << (uring.view(0, contents.size()) == expected
+                                                     && mapped.view(0, contents.size()) == expected) << "\n";
+
+            options.follow = true;
+            options.reserve_size = 4096;  // Small, so the buffer has to move
+            ZeroCopyRead uring_follower(io_path.c_str(), lock_path, options);
+            std::string appended(100000, 'z');
+            {
+                std::ofstream out(io_path, std::ios::binary | std::ios::app);
+                out.write(appended.data(), appended.size());
+            }
+            size_t size = uring_follower.waitForBytes(contents.size() + appended.size(), 5000);
+            bool follow_matches = uring_follower.view(0, contents.size()) == expected
+                && uring_follower.view(contents.size(), appended.size()) == appended;
+            {
+                std::ofstream replacement(io_path + ".new");
+                replacement << "replaced\n";
+            }
+            rename((io_path + ".new").c_str(), io_path.c_str());
+            uring_follower.refresh();
+            std::cout << "[backend] io_uring follower: size after append = " << size
+                      << ", views match = " << follow_matches
+                      << ", after replace = \"" << uring_follower.view(0, 8) << "\"\n\n";
+            unlink(io_path.c_str());
+        }
+
+        // -- Test typed views over a binary file: an int32 array starting at
+        //    an unaligned offset, and one field of an array of structs
+        {
+            struct Sample {
+                int32_t id;
+                float value;
+                char tag[8];
+            };
+            const std::string binary_path = "typed-view-test.bin";
+            {
+                std::ofstream out(binary_path, std::ios::binary);
+                out.put('H');  // 1-byte header makes the array unaligned
+                for (int32_t i = 1; i <= 100; ++i) {
+                    out.write(reinterpret_cast<const char*>(&i), sizeof(i));
+                }
+                for (int32_t i = 0; i < 4; ++i) {
+                    Sample sample = { i, i * 0.5f, "tag" };
+                    out.write(reinterpret_cast<const char*>(&sample), sizeof(sample));
+                }
+            }
+            ZeroCopyRead binary(binary_path.c_str(), lock_path);
+
+            TypedView<int32_t> values(binary, 1, 100);
+            int64_t sum = std::accumulate(values.begin(), values.end(), int64_t(0));
+            std::cout << "[TypedView] " << values.size() << " int32s, aligned = " << values.isAligned()
+                      << ", sum = " << sum << ", values[99] = " << values[99] << "\n";
+
+            StridedView<float> sample_values(binary, 1 + 100 * sizeof(int32_t) + offsetof(Sample, value),
+                                             sizeof(Sample), 4);
+            std::cout << "[StridedView] Sample::value:";
+            for (float value : sample_values) {
+                std::cout << " " << value;
+            }
+            std::cout << "\n";
+
+            try {
+                TypedView<int64_t> too_long(binary, 0, 1000);
+                std::cout << "[TypedView] out of range view NOT rejected\n";
+            } catch (const std::runtime_error& ex) {
+                std::cout << "[TypedView] out of range view rejected: " << ex.what() << "\n";
+            }
+
+            // The int operators no longer read past the end of the mapping
+            binary += binary.getFileSize() - 2;
+            std::cout << "[operator+] at the last 2 bytes: " << (binary + binary) << "\n\n";
+            unlink(binary_path.c_str());
+        }
+
+        // -- Test a reader set: three streams, one of them shorter
+        {
+            const std::string short_path = "set-short.txt";
+            {
+                std::ofstream out(short_path);
+                out << "abcdefgh";
+            }
+            ZeroCopyReadSet set({ data_path, short_path, data_path }, lock_path);
+            std::string_view streams[3];
+            bool in_range = set.views(2, 4, streams);
+            bool past_end = set.views(6, 4, streams);
+            std::cout << "[ZeroCopyReadSet] " << set.streamCount() << " streams, length = " << set.getLength()
+                      << ", views(2, 4) = \"" << streams[0] << "\" \"" << streams[1] << "\" \"" << streams[2]
+                      << "\" (" << in_range << "), views past the shortest stream rejected = " << !past_end << "\n";
+            size_t steps = 0;
+            std::string lockstep;
+            do {
+                lockstep += set.current(1);
+                steps++;
+            } while (!(++set));
+            std::cout << "[ZeroCopyReadSet] " << steps << " lockstep steps over \"" << lockstep
+                      << "\", value<char> at the end = '" << set.value<char>(0) << "'\n\n";
+            unlink(short_path.c_str());
+        }
+
+        // -- Test the zip kernels over two int32 files, a[i] = i and b[i] = 2 - i
+        {
+            const std::string a_path = "zip-a.bin";
+            const std::string b_path = "zip-b.bin";
+            {
+                std::ofstream a_out(a_path, std::ios::binary);
+                std::ofstream b_out(b_path, std::ios::binary);
+                for (int32_t i = 0; i < 200000; ++i) {  // Several kernel blocks
+                    int32_t b = 2 - i;
+                    a_out.write(reinterpret_cast<const char*>(&i), sizeof(i));
+                    b_out.write(reinterpret_cast<const char*>(&b), sizeof(b));
+                }
+            }
+            ZeroCopyRead a(a_path.c_str(), lock_path);
+            ZeroCopyRead b(b_path.c_str(), lock_path);
+            std::cout << "[zipReduce] sum = " << zipReduce<int32_t>(a, b, ZipOp::Sum)
+                      << ", min = " << zipReduce<int32_t>(a, b, ZipOp::Min)
+                      << ", max = " << zipReduce<int32_t>(a, b, ZipOp::Max)
+                      << ", dot = " << zipReduce<int32_t>(a, b, ZipOp::Dot) << "\n";
+
+            int64_t three_way = zipReduce<int32_t>(int64_t(0),
+                [](int32_t x, int32_t y, int32_t z) { return int64_t(x) * y - z; },
+                [](int64_t acc, int64_t value) { return acc + value; },
+                a, b, a);
+            std::vector<int32_t> sums;
+            zipTransform<int32_t>(std::back_inserter(sums), [](int32_t x, int32_t y) { return x + y; }, a, b);
+            std::cout << "[zipReduce] custom a*b-a = " << three_way
+                      << ", [zipTransform] " << sums.size() << " elements, all 2 = "
+                      << std::all_of(sums.begin(), sums.end(), [](int32_t v) { return v == 2; }) << "\n";
+            unlink(a_path.c_str());
+            unlink(b_path.c_str());
+
+            // int64 sums and products past the accumulator wrap modulo 2^64:
+            // 1000 x (INT64_MAX + 1) is 0, 1000 x INT64_MAX^2 is 1000
+            const std::string wide_a_path = "zip-wide-a.bin";
+            const std::string wide_b_path = "zip-wide-b.bin";
+            {
+                std::ofstream a_out(wide_a_path, std::ios::binary);
+                std::ofstream b_out(wide_b_path, std::ios::binary);
+                const int64_t big = INT64_MAX;
+                const int64_t one = 1;
+                for (int i = 0; i < 1000; ++i) {
+                    a_out.write(reinterpret_cast<const char*>(&big), sizeof(big));
+                    b_out.write(reinterpret_cast<const char*>(&one), sizeof(one));
+                }
+            }
+            ZeroCopyRead wide_a(wide_a_path.c_str(), lock_path);
+            ZeroCopyRead wide_b(wide_b_path.c_str(), lock_path);
+            int64_t wrapped_sum = zipReduce<int64_t>(wide_a, wide_b, ZipOp::Sum);
+            int64_t wrapped_dot = zipReduce<int64_t>(wide_a, wide_a, ZipOp::Dot);
+            std::cout << "[zipReduce] int64 sum wraps to " << wrapped_sum << ", dot wraps to " << wrapped_dot
+                      << "\n\n";
+            unlink(wide_a_path.c_str());
+            unlink(wide_b_path.c_str());
+            if (wrapped_sum != 0 || wrapped_dot != 1000) {
+                return 1;
+            }
         }
 
         // -- Test basic iterator: operator* and operator++()
@@ -86,6 +492,49 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
+    {
+        // Counters of a reader, dumped periodically while it is used
+        ZeroCopyRead reader(data_path, lock_path);
+        std::ostringstream dumped;
+        {
+            PeriodicStatsDump dump([&reader]() { return formatStats(reader.stats()); },
+                                   std::chrono::milliseconds(5), dumped);
+            reader.view(0, reader.getFileSize());
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+        ReaderStats stats = reader.stats();
+        std::cout << "[stats] bytes served = " << stats.bytes_served << ", lock checks = " << stats.lock_checks
+                  << ", periodic dump wrote = " << (dumped.str().find("bytes_served=") != std::string::npos) << "\n\n";
+    }
+
+    {
+        // Policy instantiations read the same bytes as ZeroCopyRead; only
+        // what they check and count differs
+        ZeroCopyRead checked(data_path, lock_path);
+        SeqlockZeroCopyRead seqlock(data_path, lock_path);
+        ImmutableZeroCopyRead immutable(data_path, lock_path);
+        size_t size = checked.getFileSize();
+        auto walk = [](auto& reader) {
+            std::string bytes;
+            do {
+                bytes += *reader;
+            } while (!(++reader));
+            return bytes;
+        };
+        std::string expected(checked.view(0, size));
+        bool same_walks = walk(checked) == expected && walk(seqlock) == expected && walk(immutable) == expected;
+        bool same_views = seqlock.view(0, size) == expected && immutable.view(0, size) == expected;
+        char first[4] = {};
+        immutable.readData(0, sizeof(first), first);
+        ReaderStats seqlock_stats = seqlock.stats();
+        ReaderStats immutable_stats = immutable.stats();
+        std::cout << "[policies] walks match = " << same_walks << ", views match = " << same_views
+                  << ", readData = \"" << std::string(first, sizeof(first)) << "\""
+                  << ", seqlock file checks = " << seqlock_stats.file_checks
+                  << ", seqlock view past the end empty = " << seqlock.view(size, 1).empty()
+                  << ", immutable bytes counted = " << immutable_stats.bytes_served << "\n\n";
+    }
+
     std::cout << "All tests complete.\n";
     return 0;
 }